@@ -0,0 +1,165 @@
+// bench_cpu.h - 실행 시점 CPUID 기반 명령어 집합(ISA) 감지
+//
+// 바이너리는 x86-64 기본(SSE2)으로 빌드하고, SIMD 커널은 함수마다
+// __attribute__((target(...)))로 자기 ISA를 지정한다. 시작할 때 CPUID로
+// 지원 여부를 확인해 실행할 커널을 고르므로 한 바이너리를 어느 호스트에서나
+// 돌릴 수 있다 (지원하지 않는 커널은 실행하지 않고 건너뛴다).
+// AVX/AVX-512는 CPU 플래그 외에 OS가 해당 레지스터 상태를 저장하는지
+// (OSXSAVE + XCR0) 도 확인한다.
+
+#ifndef BENCH_CPU_H
+#define BENCH_CPU_H
+
+#include <cpuid.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    BENCH_ISA_SSE2    = 1u << 0,
+    BENCH_ISA_SSE42   = 1u << 1,
+    BENCH_ISA_POPCNT  = 1u << 2,
+    BENCH_ISA_LZCNT   = 1u << 3,
+    BENCH_ISA_AVX     = 1u << 4,
+    BENCH_ISA_AVX2    = 1u << 5,
+    BENCH_ISA_FMA     = 1u << 6,
+    BENCH_ISA_AVX512F = 1u << 7,
+} bench_isa_t;
+
+#define BENCH_ISA_COUNT 8
+
+static const char *const bench_isa_names[BENCH_ISA_COUNT] = {
+    "sse2", "sse4.2", "popcnt", "lzcnt", "avx", "avx2", "fma", "avx512f"
+};
+
+typedef struct {
+    unsigned supported;         // CPU와 OS가 모두 지원하는 bench_isa_t 비트
+    unsigned disabled;          // 명령행에서 끈 비트 (--no-isa)
+    char vendor[13];
+} bench_cpu_t;
+
+// XCR0 읽기 (OSXSAVE가 켜진 경우에만 호출). -mxsave 없이 쓰도록 직접 인코딩.
+static inline uint64_t bench_xgetbv(uint32_t index) {
+    uint32_t lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(index));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void bench_cpu_detect(bench_cpu_t *cpu) {
+    unsigned eax, ebx, ecx, edx, max_leaf;
+    uint64_t xcr0 = 0;
+    int os_avx = 0, os_avx512 = 0;
+
+    memset(cpu, 0, sizeof(*cpu));
+    max_leaf = __get_cpuid_max(0, NULL);
+    if (max_leaf == 0 || !__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        snprintf(cpu->vendor, sizeof(cpu->vendor), "unknown");
+        return;
+    }
+    memcpy(cpu->vendor, &ebx, 4);
+    memcpy(cpu->vendor + 4, &edx, 4);
+    memcpy(cpu->vendor + 8, &ecx, 4);
+    cpu->vendor[12] = '\0';
+
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (edx & bit_SSE2)   cpu->supported |= BENCH_ISA_SSE2;
+    if (ecx & bit_SSE4_2) cpu->supported |= BENCH_ISA_SSE42;
+    if (ecx & bit_POPCNT) cpu->supported |= BENCH_ISA_POPCNT;
+    if (ecx & bit_OSXSAVE) {
+        xcr0 = bench_xgetbv(0);
+        os_avx = (xcr0 & 0x6) == 0x6;               // XMM + YMM 상태
+        os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0; // opmask + ZMM 상위 + ZMM16-31
+    }
+    if (os_avx && (ecx & bit_AVX)) {
+        cpu->supported |= BENCH_ISA_AVX;
+        if (ecx & bit_FMA) cpu->supported |= BENCH_ISA_FMA;
+    }
+
+    if (max_leaf >= 7 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if (os_avx && (ebx & bit_AVX2))        cpu->supported |= BENCH_ISA_AVX2;
+        if (os_avx512 && (ebx & bit_AVX512F))  cpu->supported |= BENCH_ISA_AVX512F;
+    }
+
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (ecx & bit_LZCNT)) {
+        cpu->supported |= BENCH_ISA_LZCNT;
+    }
+}
+
+// 실제로 쓸 수 있는 ISA 비트. AVX를 끄면 VEX/EVEX 기반인 AVX2/FMA/AVX-512도 꺼진다.
+static inline unsigned bench_cpu_usable(const bench_cpu_t *cpu) {
+    unsigned usable = cpu->supported & ~cpu->disabled;
+
+    if (!(usable & BENCH_ISA_AVX)) {
+        usable &= ~(BENCH_ISA_AVX2 | BENCH_ISA_FMA | BENCH_ISA_AVX512F);
+    }
+    return usable;
+}
+
+// required 중 이 CPU에서 쓸 수 없는 ISA 비트
+static inline unsigned bench_cpu_missing(const bench_cpu_t *cpu, unsigned required) {
+    return required & ~bench_cpu_usable(cpu);
+}
+
+// required의 모든 ISA를 쓸 수 있으면 1
+static inline int bench_cpu_has(const bench_cpu_t *cpu, unsigned required) {
+    return bench_cpu_missing(cpu, required) == 0;
+}
+
+// mask의 ISA 이름을 "avx2+fma" 형태로 buf에 쓴다
+static inline const char *bench_isa_format(unsigned mask, char *buf, size_t size) {
+    size_t len = 0;
+
+    buf[0] = '\0';
+    for (int i = 0; i < BENCH_ISA_COUNT && len < size; i++) {
+        if (mask & (1u << i)) {
+            len += snprintf(buf + len, size - len, "%s%s", len ? "+" : "", bench_isa_names[i]);
+        }
+    }
+    if (len == 0) {
+        snprintf(buf, size, "x86-64");
+    }
+    return buf;
+}
+
+// "avx512f,avx2" 같은 쉼표 목록을 비트로 바꾼다. 모르는 이름이 있으면 0을 반환
+static inline int bench_isa_parse(const char *list, unsigned *mask) {
+    char name[32];
+
+    *mask = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        int found = 0;
+
+        if (len == 0 || len >= sizeof(name)) {
+            return 0;
+        }
+        memcpy(name, list, len);
+        name[len] = '\0';
+        for (int i = 0; i < BENCH_ISA_COUNT; i++) {
+            if (strcmp(name, bench_isa_names[i]) == 0) {
+                *mask |= 1u << i;
+                found = 1;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "unknown ISA: %s\n", name);
+            return 0;
+        }
+        list += len + (list[len] == ',');
+    }
+    return 1;
+}
+
+static inline void bench_cpu_describe(const bench_cpu_t *cpu) {
+    char buf[96];
+
+    unsigned usable = bench_cpu_usable(cpu);
+
+    printf("ISA (%s): %s", cpu->vendor, bench_isa_format(usable, buf, sizeof(buf)));
+    if (cpu->supported & ~usable) {
+        printf(" (disabled: %s)", bench_isa_format(cpu->supported & ~usable, buf, sizeof(buf)));
+    }
+    printf("\n");
+}
+
+#endif // BENCH_CPU_H
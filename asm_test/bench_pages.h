@@ -0,0 +1,182 @@
+// bench_pages.h - 페이지 크기를 지정한 측정용 메모리 할당
+//
+// 같은 접근 패턴이라도 페이지 크기에 따라 TLB 미스와 페이지 워크 비용이 달라진다.
+// 요청 종류:
+//   default  시스템 THP 정책 그대로 (mmap만 함)
+//   4k       madvise(MADV_NOHUGEPAGE)로 4KB 페이지 강제
+//   thp      2MB 정렬 + madvise(MADV_HUGEPAGE) (transparent huge page)
+//   hugetlb  MAP_HUGETLB 2MB 페이지 (vm.nr_hugepages 예약 필요)
+// hugetlb 예약이 모자라면 thp로, THP가 꺼져 있으면 4k로 내려간다 (bench_pages_t.kind에
+// 실제로 쓴 종류가 남는다). 할당 직후 모든 페이지를 건드려 폴트를 측정 밖으로 뺀다.
+// THP가 never여도 madvise(MADV_HUGEPAGE)는 성공하므로, 폴트 후 /proc/self/smaps의
+// AnonHugePages가 0이면 thp를 거절된 것으로 보고 4k로 내려간다.
+
+#ifndef BENCH_PAGES_H
+#define BENCH_PAGES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+#define BENCH_HUGE_PAGE_SIZE (2UL << 20)
+#define BENCH_SMALL_PAGE_SIZE 4096UL
+
+typedef enum {
+    BENCH_PAGES_DEFAULT = 0,
+    BENCH_PAGES_4K,
+    BENCH_PAGES_THP,
+    BENCH_PAGES_HUGETLB,
+    BENCH_PAGES_COUNT
+} bench_page_kind_t;
+
+static const char *const bench_page_names[BENCH_PAGES_COUNT] = { "default", "4k", "thp", "hugetlb" };
+
+typedef struct {
+    char *base;                 // 사용할 주소 (thp는 2MB 정렬)
+    size_t size;                // 요청 크기
+    void *map;                  // munmap할 주소와 크기
+    size_t map_size;
+    bench_page_kind_t requested;
+    bench_page_kind_t kind;     // 실제로 쓴 종류 (대체 후)
+} bench_pages_t;
+
+// "4k", "thp" 등을 종류로 바꾼다. 모르는 이름이면 0
+static inline int bench_pages_parse(const char *name, bench_page_kind_t *kind) {
+    for (int i = 0; i < BENCH_PAGES_COUNT; i++) {
+        if (strcmp(name, bench_page_names[i]) == 0) {
+            *kind = (bench_page_kind_t)i;
+            return 1;
+        }
+    }
+    fprintf(stderr, "unknown page kind: %s (default, 4k, thp, hugetlb)\n", name);
+    return 0;
+}
+
+static inline size_t bench_pages_round(size_t size, size_t unit) {
+    return (size + unit - 1) / unit * unit;
+}
+
+// 버퍼 중 huge page로 덮인 비율 (0..1). hugetlb는 항상 1, smaps를 읽을 수 없으면 -1
+static inline double bench_pages_huge_fraction(const bench_pages_t *pages) {
+    uintptr_t lo = (uintptr_t)pages->base, hi = lo + pages->size;
+    unsigned long start, end, kb;
+    size_t huge = 0;
+    int inside = 0;
+    char line[256];
+    FILE *f;
+
+    if (pages->kind == BENCH_PAGES_HUGETLB) {
+        return 1.0;
+    }
+    f = fopen("/proc/self/smaps", "r");
+    if (!f) {
+        return -1.0;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            inside = start < hi && end > lo;
+        } else if (inside && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            huge += kb * 1024;
+        }
+    }
+    fclose(f);
+    return pages->size ? (huge > pages->size ? 1.0 : (double)huge / pages->size) : 0.0;
+}
+
+// kind 하나로만 시도 (대체 없음). 성공하면 1
+static inline int bench_pages_try(bench_pages_t *pages, size_t size, bench_page_kind_t kind) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t map_size = size;
+    char *map;
+
+    if (kind == BENCH_PAGES_HUGETLB) {
+        flags |= MAP_HUGETLB | MAP_HUGE_2MB;
+        map_size = bench_pages_round(size, BENCH_HUGE_PAGE_SIZE);
+    } else if (kind == BENCH_PAGES_THP) {
+        map_size = bench_pages_round(size, BENCH_HUGE_PAGE_SIZE) + BENCH_HUGE_PAGE_SIZE;
+    }
+
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (map == MAP_FAILED) {
+        return 0;
+    }
+    pages->map = map;
+    pages->map_size = map_size;
+    pages->base = map;
+    pages->size = size;
+    pages->kind = kind;
+
+    if (kind == BENCH_PAGES_THP) {
+        uintptr_t aligned = bench_pages_round((uintptr_t)map, BENCH_HUGE_PAGE_SIZE);
+        pages->base = (char *)aligned;
+        if (madvise(pages->base, bench_pages_round(size, BENCH_HUGE_PAGE_SIZE), MADV_HUGEPAGE) != 0) {
+            munmap(map, map_size);
+            return 0;
+        }
+    } else if (kind == BENCH_PAGES_4K) {
+        madvise(map, map_size, MADV_NOHUGEPAGE);
+    }
+
+    // 첫 접근 폴트를 미리 처리 (hugetlb/thp는 2MB 단위로 할당된다)
+    for (size_t offset = 0; offset < size; offset += BENCH_SMALL_PAGE_SIZE) {
+        pages->base[offset] = 0;
+    }
+    // huge page를 하나도 받지 못했으면 thp가 아니다 (smaps를 못 읽으면 그대로 둔다)
+    if (kind == BENCH_PAGES_THP && bench_pages_huge_fraction(pages) == 0.0) {
+        munmap(map, map_size);
+        pages->map = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// size 바이트를 kind 페이지로 할당. 실패하면 hugetlb -> thp -> 4k 순으로 대체한다.
+static inline int bench_pages_alloc(bench_pages_t *pages, size_t size, bench_page_kind_t kind) {
+    memset(pages, 0, sizeof(*pages));
+    pages->requested = kind;
+
+    if (kind == BENCH_PAGES_HUGETLB) {
+        if (bench_pages_try(pages, size, BENCH_PAGES_HUGETLB)) {
+            return 1;
+        }
+        kind = BENCH_PAGES_THP;
+    }
+    if (kind == BENCH_PAGES_THP) {
+        if (bench_pages_try(pages, size, BENCH_PAGES_THP)) {
+            return 1;
+        }
+        kind = BENCH_PAGES_4K;
+    }
+    return bench_pages_try(pages, size, kind);
+}
+
+static inline void bench_pages_free(bench_pages_t *pages) {
+    if (pages->map) {
+        munmap(pages->map, pages->map_size);
+        pages->map = NULL;
+    }
+}
+
+// "thp (requested hugetlb), 100% huge" 형태의 설명
+static inline const char *bench_pages_describe(const bench_pages_t *pages, char *buf, size_t size) {
+    double huge = bench_pages_huge_fraction(pages);
+    size_t len = snprintf(buf, size, "%s", bench_page_names[pages->kind]);
+
+    if (pages->kind != pages->requested && len < size) {
+        len += snprintf(buf + len, size - len, " (requested %s)", bench_page_names[pages->requested]);
+    }
+    if (huge >= 0.0 && len < size) {
+        snprintf(buf + len, size - len, ", %.0f%% huge", huge * 100.0);
+    }
+    return buf;
+}
+
+#endif // BENCH_PAGES_H
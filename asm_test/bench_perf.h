@@ -0,0 +1,210 @@
+// bench_perf.h - 커널별 하드웨어 카운터 그룹 (comprehensive_asm_test.c 용)
+//
+// perf_event_open으로 호출 스레드의 카운터 그룹을 열고, 측정 구간에서만
+// enable/disable 해서 커널 본문이 실행된 동안의 값만 누적한다.
+// 카운터 수가 적은 CPU에서도 스케줄될 수 있도록 두 그룹으로 나눈다:
+//   core  그룹: cycles, instructions, branch-misses, L1D read misses, LLC misses
+//   stall 그룹: frontend/backend stall cycles (지원하는 CPU에서만)
+// 열리지 않은 이벤트는 unavailable로 남고 출력에서 "n/a"가 된다.
+
+#ifndef BENCH_PERF_H
+#define BENCH_PERF_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+typedef enum {
+    BENCH_PERF_CYCLES = 0,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_L1D_MISSES,
+    BENCH_PERF_LLC_MISSES,
+    BENCH_PERF_STALL_FRONTEND,
+    BENCH_PERF_STALL_BACKEND,
+    BENCH_PERF_EVENT_COUNT
+} bench_perf_event_t;
+
+#define BENCH_PERF_GROUP_COUNT 2
+
+typedef struct {
+    const char *name;
+    int group;              // 0: core, 1: stall
+    uint32_t type;
+    uint64_t config;
+} bench_perf_event_def_t;
+
+#define BENCH_PERF_CACHE_CONFIG(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+static const bench_perf_event_def_t bench_perf_events[BENCH_PERF_EVENT_COUNT] = {
+    { "cycles",          0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",    0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "branch-misses",   0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "L1D-read-misses", 0, PERF_TYPE_HW_CACHE,
+      BENCH_PERF_CACHE_CONFIG(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                              PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    { "LLC-misses",      0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "stalls-frontend", 1, PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+    { "stalls-backend",  1, PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+};
+
+typedef struct {
+    int fd[BENCH_PERF_EVENT_COUNT];         // 이벤트별 fd (-1이면 없음)
+    int leader[BENCH_PERF_GROUP_COUNT];     // 그룹별 리더 fd (-1이면 그룹 없음)
+    int opened;                             // 열린 이벤트 수
+    char unavailable_reason[96];            // 하나도 열지 못한 이유
+} bench_perf_t;
+
+typedef struct {
+    int available[BENCH_PERF_EVENT_COUNT];  // 0이면 n/a
+    int multiplexed[BENCH_PERF_EVENT_COUNT];// 1이면 시간 비율로 보정된 값
+    double value[BENCH_PERF_EVENT_COUNT];
+} bench_perf_counts_t;
+
+// 호출 스레드의 카운터 그룹을 연다 (모두 disabled 상태). 열린 이벤트 수를 반환.
+static inline int bench_perf_open(bench_perf_t *perf) {
+    int first_errno = 0;
+
+    memset(perf, 0, sizeof(*perf));
+    for (int g = 0; g < BENCH_PERF_GROUP_COUNT; g++) {
+        perf->leader[g] = -1;
+    }
+
+    for (int i = 0; i < BENCH_PERF_EVENT_COUNT; i++) {
+        const bench_perf_event_def_t *def = &bench_perf_events[i];
+        int *leader = &perf->leader[def->group];
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.type = def->type;
+        attr.size = sizeof(attr);
+        attr.config = def->config;
+        attr.disabled = *leader < 0;    // 리더만 disabled, 멤버는 리더를 따른다
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        perf->fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, *leader, 0);
+        if (perf->fd[i] < 0) {
+            if (!first_errno) {
+                first_errno = errno;
+            }
+            perf->fd[i] = -1;
+            continue;
+        }
+        if (*leader < 0) {
+            *leader = perf->fd[i];
+        }
+        perf->opened++;
+    }
+
+    if (perf->opened == 0) {
+        snprintf(perf->unavailable_reason, sizeof(perf->unavailable_reason),
+                 "perf_event_open: %s", strerror(first_errno));
+    }
+    return perf->opened;
+}
+
+static inline void bench_perf_close(bench_perf_t *perf) {
+    for (int i = 0; i < BENCH_PERF_EVENT_COUNT; i++) {
+        if (perf->fd[i] >= 0) {
+            close(perf->fd[i]);
+            perf->fd[i] = -1;
+        }
+    }
+    for (int g = 0; g < BENCH_PERF_GROUP_COUNT; g++) {
+        perf->leader[g] = -1;
+    }
+    perf->opened = 0;
+}
+
+static inline void bench_perf_group_ioctl(const bench_perf_t *perf, unsigned long request) {
+    for (int g = 0; g < BENCH_PERF_GROUP_COUNT; g++) {
+        if (perf->leader[g] >= 0) {
+            ioctl(perf->leader[g], request, PERF_IOC_FLAG_GROUP);
+        }
+    }
+}
+
+// 누적값 초기화 (측정 구간 시작 전에 한 번)
+static inline void bench_perf_reset(const bench_perf_t *perf) {
+    bench_perf_group_ioctl(perf, PERF_EVENT_IOC_RESET);
+}
+
+// 측정 구간 시작/종료. 여러 구간의 값이 reset 전까지 누적된다.
+static inline void bench_perf_start(const bench_perf_t *perf) {
+    bench_perf_group_ioctl(perf, PERF_EVENT_IOC_ENABLE);
+}
+
+static inline void bench_perf_stop(const bench_perf_t *perf) {
+    bench_perf_group_ioctl(perf, PERF_EVENT_IOC_DISABLE);
+}
+
+// 누적값 읽기. 다른 그룹과 번갈아 스케줄된 경우 enabled/running 비율로 보정한다.
+static inline void bench_perf_read(const bench_perf_t *perf, bench_perf_counts_t *counts) {
+    memset(counts, 0, sizeof(*counts));
+    for (int i = 0; i < BENCH_PERF_EVENT_COUNT; i++) {
+        uint64_t buf[3];    // value, time_enabled, time_running
+
+        if (perf->fd[i] < 0 || read(perf->fd[i], buf, sizeof(buf)) != sizeof(buf)) {
+            continue;
+        }
+        if (buf[2] == 0) {
+            continue;       // 한 번도 스케줄되지 않음
+        }
+        counts->available[i] = 1;
+        counts->multiplexed[i] = buf[2] < buf[1];
+        counts->value[i] = (double)buf[0] * buf[1] / buf[2];
+    }
+}
+
+// 명령어 1개당 이벤트 수. 없으면 음수.
+static inline double bench_perf_per_op(const bench_perf_counts_t *counts,
+                                       bench_perf_event_t event, uint64_t ops) {
+    if (!counts->available[event] || ops == 0) {
+        return -1.0;
+    }
+    return counts->value[event] / ops;
+}
+
+// 이벤트 비율 (예: IPC = instructions / cycles). 없으면 음수.
+static inline double bench_perf_ratio(const bench_perf_counts_t *counts,
+                                      bench_perf_event_t num, bench_perf_event_t den) {
+    if (!counts->available[num] || !counts->available[den] || counts->value[den] <= 0.0) {
+        return -1.0;
+    }
+    return counts->value[num] / counts->value[den];
+}
+
+// 값 또는 "n/a"를 고정 폭으로 출력 (음수 = 없음)
+static inline void bench_perf_print_value(double value, int width, int precision) {
+    if (value < 0.0) {
+        printf(" %*s", width, "n/a");
+    } else {
+        printf(" %*.*f", width, precision, value);
+    }
+}
+
+// 열린 카운터 설명 출력
+static inline void bench_perf_describe(const bench_perf_t *perf) {
+    printf("Hardware counters: ");
+    if (perf->opened == 0) {
+        printf("n/a (%s)\n", perf->unavailable_reason);
+        return;
+    }
+    for (int i = 0, first = 1; i < BENCH_PERF_EVENT_COUNT; i++) {
+        if (perf->fd[i] >= 0) {
+            printf("%s%s", first ? "" : ", ", bench_perf_events[i].name);
+            first = 0;
+        }
+    }
+    printf("\n");
+}
+
+#endif // BENCH_PERF_H
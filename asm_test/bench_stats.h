@@ -0,0 +1,217 @@
+// bench_stats.h - 반복 샘플링 + 통계 엔진 (comprehensive_asm_test.c, main.c 공용)
+//
+// 커널마다 샘플을 반복 수집하고, 이상치를 제외한 샘플의 95% 신뢰구간
+// 반폭이 평균 대비 ci_percent 이하가 되거나 시간 예산을 다 쓰면 멈춘다.
+// 이상치는 전체 샘플의 중앙값/MAD로 판정하고, 나머지 통계(min, median, mean,
+// p90/p99, stddev, CI)는 이상치를 뺀 샘플로 계산한다. MAD만 전체 샘플 기준이다.
+// CI는 |평균| 대비라서 보정 후 음수인 결과도 수렴할 수 있고, 평균이 0이면 CI가 무한대라 수렴하지 않는다.
+// 헤더 전용이므로 필요한 파일에서 include만 하면 된다.
+
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_Z95 1.96  // 95% 신뢰구간의 정규분포 계수
+
+typedef struct {
+    double ci_percent;      // 목표 신뢰구간 반폭 (평균 대비 %)
+    double time_budget_s;   // 커널당 최대 샘플링 시간 (초)
+    int min_samples;        // 수렴 판정 전 최소 샘플 수
+    int max_samples;        // 최대 샘플 수
+    double outlier_mads;    // |x - median| > outlier_mads * MAD 이면 이상치
+} bench_sampling_config_t;
+
+#define BENCH_SAMPLING_DEFAULTS { 1.0, 1.0, 10, 1000, 5.0 }
+
+typedef struct {
+    int samples;            // 수집한 전체 샘플 수
+    int outliers;           // 통계에서 제외한 이상치 수
+    int converged;          // 신뢰구간 목표 도달 여부
+    double min;             // min/median/mean/p90/p99/stddev: 이상치 제외
+    double median;
+    double mean;
+    double p90;
+    double p99;
+    double mad;             // median absolute deviation (전체 샘플)
+    double stddev;
+    double ci_percent;      // 95% 신뢰구간 반폭 (|평균| 대비 %, 평균이 0이면 inf)
+} bench_stats_t;
+
+// 샘플 1개를 측정해 값(예: cycles/op)을 반환하는 콜백
+typedef double (*bench_sample_fn)(void *arg);
+
+static inline int bench_compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 정렬된 배열의 백분위수 (선형 보간)
+static inline double bench_percentile(const double *sorted, int n, double pct) {
+    double pos = (n - 1) * pct / 100.0;
+    int lo = (int)pos;
+    int hi = lo + 1 < n ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+// values[0..n)의 통계 계산. scratch는 n개 이상의 double 공간.
+static inline void bench_stats_compute(const double *values, int n, double outlier_mads,
+                                       double *scratch, bench_stats_t *out) {
+    double sum = 0.0, sq = 0.0;
+    int kept = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->samples = n;
+    if (n == 0) {
+        return;
+    }
+
+    // 이상치 판정 기준: 전체 샘플의 중앙값과 MAD
+    double median_all;
+
+    memcpy(scratch, values, n * sizeof(double));
+    qsort(scratch, n, sizeof(double), bench_compare_double);
+    median_all = bench_percentile(scratch, n, 50.0);
+
+    for (int i = 0; i < n; i++) {
+        scratch[i] = fabs(values[i] - median_all);
+    }
+    qsort(scratch, n, sizeof(double), bench_compare_double);
+    out->mad = bench_percentile(scratch, n, 50.0);
+
+    // 이상치를 뺀 샘플을 scratch에 모은다 (중앙값 근처 샘플은 항상 남으므로 kept >= 1)
+    for (int i = 0; i < n; i++) {
+        if (out->mad > 0.0 && fabs(values[i] - median_all) > outlier_mads * out->mad) {
+            out->outliers++;
+            continue;
+        }
+        scratch[kept++] = values[i];
+        sum += values[i];
+        sq += values[i] * values[i];
+    }
+    qsort(scratch, kept, sizeof(double), bench_compare_double);
+    out->min = scratch[0];
+    out->median = bench_percentile(scratch, kept, 50.0);
+    out->p90 = bench_percentile(scratch, kept, 90.0);
+    out->p99 = bench_percentile(scratch, kept, 99.0);
+
+    out->mean = sum / kept;
+    if (kept > 1) {
+        double var = (sq - sum * sum / kept) / (kept - 1);
+        out->stddev = var > 0.0 ? sqrt(var) : 0.0;
+    }
+    if (out->mean != 0.0) {
+        out->ci_percent = BENCH_Z95 * out->stddev / sqrt(kept) / fabs(out->mean) * 100.0;
+    } else if (out->stddev > 0.0) {
+        out->ci_percent = INFINITY;
+    }
+}
+
+static inline double bench_elapsed_s(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// 수렴하거나 시간 예산/최대 샘플 수에 도달할 때까지 fn을 반복 측정
+static inline void bench_sample(const bench_sampling_config_t *cfg, bench_sample_fn fn,
+                                void *arg, bench_stats_t *out) {
+    double *values = malloc(2 * cfg->max_samples * sizeof(double));
+    double *scratch;
+    struct timespec start;
+    int n = 0;
+
+    if (!values) {
+        fprintf(stderr, "bench_sample: could not allocate %d samples\n", cfg->max_samples);
+        exit(1);
+    }
+    scratch = values + cfg->max_samples;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (n < cfg->max_samples) {
+        values[n++] = fn(arg);
+
+        if (n >= cfg->min_samples) {
+            bench_stats_compute(values, n, cfg->outlier_mads, scratch, out);
+            if (out->ci_percent <= cfg->ci_percent) {
+                out->converged = 1;
+                break;
+            }
+            if (bench_elapsed_s(&start) >= cfg->time_budget_s) {
+                break;
+            }
+        }
+    }
+    if (n < cfg->min_samples) {
+        bench_stats_compute(values, n, cfg->outlier_mads, scratch, out);
+    }
+
+    free(values);
+}
+
+// ============ 샘플링 명령행 옵션 ============
+//
+// 각 프로그램의 getopt_long 옵션 배열에 BENCH_SAMPLING_LONG_OPTIONS를 넣고,
+// getopt_long이 돌려준 값을 bench_sampling_handle_option에 넘긴다.
+
+enum {
+    BENCH_OPT_CI = 0x100,
+    BENCH_OPT_BUDGET,
+    BENCH_OPT_MIN_SAMPLES,
+    BENCH_OPT_MAX_SAMPLES,
+};
+
+#define BENCH_SAMPLING_LONG_OPTIONS \
+    { "ci",          required_argument, NULL, BENCH_OPT_CI }, \
+    { "budget",      required_argument, NULL, BENCH_OPT_BUDGET }, \
+    { "min-samples", required_argument, NULL, BENCH_OPT_MIN_SAMPLES }, \
+    { "max-samples", required_argument, NULL, BENCH_OPT_MAX_SAMPLES }
+
+// 샘플링 옵션이면 cfg에 반영하고 1, 아니면 0을 반환
+static inline int bench_sampling_handle_option(bench_sampling_config_t *cfg, int opt,
+                                               const char *arg) {
+    switch (opt) {
+    case BENCH_OPT_CI:          cfg->ci_percent = atof(arg); return 1;
+    case BENCH_OPT_BUDGET:      cfg->time_budget_s = atof(arg); return 1;
+    case BENCH_OPT_MIN_SAMPLES: cfg->min_samples = atoi(arg); return 1;
+    case BENCH_OPT_MAX_SAMPLES: cfg->max_samples = atoi(arg); return 1;
+    default:                    return 0;
+    }
+}
+
+// 설정이 유효하면 1, 아니면 오류를 출력하고 0을 반환
+static inline int bench_sampling_validate(const bench_sampling_config_t *cfg) {
+    if (cfg->min_samples < 1 || cfg->max_samples < cfg->min_samples) {
+        fprintf(stderr, "invalid sample limits: min %d, max %d\n",
+                cfg->min_samples, cfg->max_samples);
+        return 0;
+    }
+    return 1;
+}
+
+static inline void bench_sampling_print_usage(const bench_sampling_config_t *cfg) {
+    printf("  --ci PCT            target 95%% confidence interval half-width (default %.2f)\n",
+           cfg->ci_percent);
+    printf("  --budget SEC        sampling time budget per kernel (default %.2f)\n",
+           cfg->time_budget_s);
+    printf("  --min-samples N     minimum samples per kernel (default %d)\n", cfg->min_samples);
+    printf("  --max-samples N     maximum samples per kernel (default %d)\n", cfg->max_samples);
+}
+
+// 통계 테이블 헤더/행 출력
+static inline void bench_stats_print_header(const char *label) {
+    printf("%-32s %6s %4s %10s %10s %10s %10s %10s %9s %7s\n",
+           label, "N", "Out", "Min", "Median", "Mean", "P90", "P99", "MAD", "CI(%)");
+}
+
+static inline void bench_stats_print_row(const char *name, const bench_stats_t *s) {
+    printf("%-32s %6d %4d %10.3f %10.3f %10.3f %10.3f %10.3f %9.3f %6.2f%s\n",
+           name, s->samples, s->outliers, s->min, s->median, s->mean,
+           s->p90, s->p99, s->mad, s->ci_percent, s->converged ? "" : "*");
+}
+
+#endif // BENCH_STATS_H
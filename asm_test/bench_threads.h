@@ -0,0 +1,220 @@
+// bench_threads.h - CPU 토폴로지 + 고정(pinned) 스레드 팀 (멀티코어 측정 공용)
+//
+// 토폴로지는 sysfs의 core_id/physical_package_id로 읽고, 스레드 배치 순서를
+// "물리 코어당 하나씩 먼저, 그 다음 SMT 형제" 로 정한다. 따라서 스레드 수를
+// 1..N으로 늘리면 physical_cores를 넘는 지점부터 SMT 형제가 실행 포트를 공유한다.
+// 팀의 각 스레드는 시작하자마자 지정된 CPU에 고정되고, bench_team_sync로
+// 모든 스레드가 같은 지점에서 동시에 출발한다. 한 스레드라도 고정에 실패하면
+// (cgroup cpuset 변경, 오프라인 CPU 등) 팀 전체가 fn을 건너뛰고 bench_team_run이 실패를 반환한다.
+// CPU_SET, pthread_setaffinity_np는 GNU 확장이므로 include하는 파일 맨 위에
+// _GNU_SOURCE를 정의해야 한다.
+
+#ifndef BENCH_THREADS_H
+#define BENCH_THREADS_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_MAX_CPUS 256
+
+typedef struct {
+    int count;                          // 사용 가능한 CPU 수
+    int physical_cores;                 // 서로 다른 물리 코어 수
+    int cpus[BENCH_MAX_CPUS];           // 스레드 배치 순서
+    int smt_sibling[BENCH_MAX_CPUS];    // cpus[i]가 앞선 CPU와 코어를 공유하면 1
+} bench_topology_t;
+
+// sysfs 토폴로지 값 읽기 (없으면 -1)
+static inline int bench_read_topology_id(int cpu, const char *name) {
+    char path[96];
+    FILE *f;
+    int value = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+// cpu가 쓰는 마지막 레벨 캐시(보통 L3, AMD에서는 CCX 단위)의 sysfs id (모르면 -1)
+static inline int bench_read_llc_id(int cpu) {
+    int best_level = 0, id = -1;
+
+    for (int index = 0; index < 16; index++) {
+        char path[96];
+        int level = 0, value = -1;
+        FILE *f;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        if (fscanf(f, "%d", &level) != 1) {
+            level = 0;
+        }
+        fclose(f);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/id", cpu, index);
+        f = fopen(path, "r");
+        if (f) {
+            if (fscanf(f, "%d", &value) != 1) {
+                value = -1;
+            }
+            fclose(f);
+        }
+        if (level > best_level && value >= 0) {
+            best_level = level;
+            id = value;
+        }
+    }
+    return id;
+}
+
+// 현재 프로세스가 사용할 수 있는 CPU를 배치 순서대로 정리
+static inline void bench_topology_detect(bench_topology_t *topo) {
+    cpu_set_t allowed;
+    int allowed_cpus[BENCH_MAX_CPUS], core_key[BENCH_MAX_CPUS], taken[BENCH_MAX_CPUS] = {0};
+    int n = 0;
+
+    topo->count = 0;
+    topo->physical_cores = 0;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+    for (int cpu = 0; cpu < BENCH_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            int package = bench_read_topology_id(cpu, "physical_package_id");
+            int core = bench_read_topology_id(cpu, "core_id");
+
+            allowed_cpus[n] = cpu;
+            // 토폴로지를 모르면 CPU마다 별도 코어로 취급
+            core_key[n] = core < 0 ? -1 - cpu : (package < 0 ? 0 : package) * 65536 + core;
+            n++;
+        }
+    }
+
+    // 1차: 아직 등장하지 않은 물리 코어의 첫 CPU
+    for (int i = 0; i < n; i++) {
+        int seen = 0;
+
+        for (int j = 0; j < i; j++) {
+            if (core_key[j] == core_key[i]) {
+                seen = 1;
+                break;
+            }
+        }
+        if (!seen) {
+            topo->cpus[topo->count] = allowed_cpus[i];
+            topo->smt_sibling[topo->count] = 0;
+            topo->count++;
+            taken[i] = 1;
+        }
+    }
+    topo->physical_cores = topo->count;
+
+    // 2차: 나머지 SMT 형제
+    for (int i = 0; i < n; i++) {
+        if (!taken[i]) {
+            topo->cpus[topo->count] = allowed_cpus[i];
+            topo->smt_sibling[topo->count] = 1;
+            topo->count++;
+        }
+    }
+}
+
+static inline void bench_topology_describe(const bench_topology_t *topo) {
+    printf("CPU order: ");
+    for (int i = 0; i < topo->count; i++) {
+        printf("%s%d%s", i ? " " : "", topo->cpus[i], topo->smt_sibling[i] ? "*" : "");
+    }
+    printf(" (%d physical cores, * = SMT sibling)\n", topo->physical_cores);
+}
+
+// 호출 스레드를 cpu에 고정. 성공하면 0.
+static inline int bench_pin_cpu(int cpu) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// ============ 고정 스레드 팀 ============
+
+typedef struct bench_team bench_team_t;
+typedef void (*bench_team_fn)(bench_team_t *team, int index, void *arg);
+
+struct bench_team {
+    int size;
+    const int *cpus;                // 스레드 index가 고정될 CPU
+    pthread_barrier_t barrier;
+    bench_team_fn fn;
+    void *arg;
+    int pin_failed;                 // 고정에 실패한 스레드가 있으면 1
+};
+
+typedef struct {
+    bench_team_t *team;
+    int index;
+} bench_team_member_t;
+
+// 팀 전체가 도착할 때까지 대기
+static inline void bench_team_sync(bench_team_t *team) {
+    pthread_barrier_wait(&team->barrier);
+}
+
+static inline void *bench_team_entry(void *arg) {
+    bench_team_member_t *member = arg;
+    bench_team_t *team = member->team;
+
+    int cpu = team->cpus[member->index];
+
+    if (bench_pin_cpu(cpu) != 0) {
+        fprintf(stderr, "bench_team_run: could not pin thread %d to CPU %d\n", member->index, cpu);
+        __atomic_store_n(&team->pin_failed, 1, __ATOMIC_RELAXED);
+    }
+    // 모두 고정을 마친 뒤 함께 결정한다 (fn 안의 bench_team_sync가 어긋나지 않도록)
+    bench_team_sync(team);
+    if (!__atomic_load_n(&team->pin_failed, __ATOMIC_RELAXED)) {
+        team->fn(team, member->index, team->arg);
+    }
+    return NULL;
+}
+
+// cpus[0..size)에 고정된 size개의 스레드로 fn을 실행하고 모두 끝날 때까지 기다린다.
+// 스레드 0도 호출 스레드가 아닌 새 스레드다. 고정에 실패하면 fn을 실행하지 않고 -1, 성공하면 0
+static inline int bench_team_run(int size, const int *cpus, bench_team_fn fn, void *arg) {
+    bench_team_t team = { .size = size, .cpus = cpus, .fn = fn, .arg = arg };
+    pthread_t *threads = malloc(size * sizeof(*threads));
+    bench_team_member_t *members = malloc(size * sizeof(*members));
+
+    pthread_barrier_init(&team.barrier, NULL, size);
+    for (int i = 0; i < size; i++) {
+        members[i].team = &team;
+        members[i].index = i;
+        if (pthread_create(&threads[i], NULL, bench_team_entry, &members[i]) != 0) {
+            // 일부만 시작되면 나머지가 배리어에서 영원히 대기하므로 중단한다
+            fprintf(stderr, "bench_team_run: could not start thread %d of %d\n", i, size);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&team.barrier);
+
+    free(members);
+    free(threads);
+    return team.pin_failed ? -1 : 0;
+}
+
+#endif // BENCH_THREADS_H
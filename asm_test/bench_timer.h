@@ -0,0 +1,167 @@
+// bench_timer.h - 사이클 측정 백엔드 (comprehensive_asm_test.c, main.c, manual_benchmark.c,
+//                  native/complexity.hpp 공용)
+//
+// 1순위: perf_event_open으로 스레드별 core cycles 카운터를 열고 사용자 공간에서
+//        rdpmc로 읽는다. 터보/주파수 변화와 무관하게 실제 코어 클럭을 센다.
+// 2순위: perf 카운터를 쓸 수 없으면 (perf_event_paranoid, 가상화 등)
+//        lfence로 직렬화한 rdtsc/rdtscp로 TSC 기준 사이클을 센다.
+// 카운터는 스레드별이므로 측정하는 스레드마다 bench_timer_init을 호출한다.
+
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+typedef enum {
+    BENCH_CLOCK_TSC = 0,    // 직렬화된 rdtsc/rdtscp (기준 클럭)
+    BENCH_CLOCK_RDPMC,      // perf core cycles 카운터 + rdpmc (코어 클럭)
+} bench_clock_kind_t;
+
+typedef struct {
+    bench_clock_kind_t kind;
+    int fd;                                 // perf 이벤트 fd (TSC면 -1)
+    struct perf_event_mmap_page *page;      // rdpmc용 사용자 페이지
+    char fallback_reason[96];               // TSC로 대체된 이유
+} bench_timer_t;
+
+static inline const char *bench_clock_name(bench_clock_kind_t kind) {
+    return kind == BENCH_CLOCK_RDPMC ? "core-cycles/rdpmc" : "tsc/rdtscp";
+}
+
+// 측정 시작: 앞선 명령어가 끝난 뒤 읽고, 뒤 명령어가 먼저 시작하지 않게 막는다
+static inline uint64_t bench_tsc_start(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("lfence\n\trdtsc\n\tlfence" : "=a"(lo), "=d"(hi) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// 측정 종료: rdtscp는 앞선 명령어 완료를 기다리고, lfence로 뒤 명령어를 막는다
+static inline uint64_t bench_tsc_stop(void) {
+    uint32_t lo, hi, aux;
+    __asm__ volatile ("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t bench_rdpmc(uint32_t counter) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// perf 사용자 페이지의 seqlock 프로토콜로 카운터 값을 읽는다
+static inline uint64_t bench_rdpmc_read(const struct perf_event_mmap_page *page) {
+    uint32_t seq, idx;
+    uint64_t count;
+
+    do {
+        seq = page->lock;
+        __asm__ volatile ("" : : : "memory");
+        idx = page->index;
+        count = page->offset;
+        if (idx) {
+            uint64_t pmc = bench_rdpmc(idx - 1);
+            unsigned shift = 64 - page->pmc_width;
+            count += (uint64_t)(((int64_t)(pmc << shift)) >> shift);
+        }
+        __asm__ volatile ("" : : : "memory");
+    } while (page->lock != seq);
+
+    return count;
+}
+
+static inline void bench_timer_fallback(bench_timer_t *timer, const char *reason) {
+    if (timer->page) {
+        munmap(timer->page, sysconf(_SC_PAGESIZE));
+        timer->page = NULL;
+    }
+    if (timer->fd >= 0) {
+        close(timer->fd);
+        timer->fd = -1;
+    }
+    timer->kind = BENCH_CLOCK_TSC;
+    snprintf(timer->fallback_reason, sizeof(timer->fallback_reason), "%s", reason);
+}
+
+// 호출 스레드의 타이머 초기화. force_tsc이면 perf 카운터를 시도하지 않는다.
+// 반환값은 실제로 선택된 클럭.
+static inline bench_clock_kind_t bench_timer_init(bench_timer_t *timer, int force_tsc) {
+    struct perf_event_attr attr;
+
+    memset(timer, 0, sizeof(*timer));
+    timer->fd = -1;
+    if (force_tsc) {
+        bench_timer_fallback(timer, "forced by option");
+        return timer->kind;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    timer->fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (timer->fd < 0) {
+        char reason[96];
+        snprintf(reason, sizeof(reason), "perf_event_open: %s", strerror(errno));
+        bench_timer_fallback(timer, reason);
+        return timer->kind;
+    }
+
+    // C++(native/complexity.hpp)에서도 include하므로 명시적으로 캐스트
+    timer->page = (struct perf_event_mmap_page *)mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ,
+                                                      MAP_SHARED, timer->fd, 0);
+    if (timer->page == MAP_FAILED) {
+        timer->page = NULL;
+        bench_timer_fallback(timer, "perf mmap failed");
+        return timer->kind;
+    }
+    if (!timer->page->cap_user_rdpmc || timer->page->index == 0) {
+        bench_timer_fallback(timer, "rdpmc not permitted");
+        return timer->kind;
+    }
+
+    timer->kind = BENCH_CLOCK_RDPMC;
+    return timer->kind;
+}
+
+static inline void bench_timer_close(bench_timer_t *timer) {
+    bench_timer_fallback(timer, "closed");
+}
+
+static inline uint64_t bench_timer_start(const bench_timer_t *timer) {
+    if (timer->kind == BENCH_CLOCK_RDPMC) {
+        __asm__ volatile ("lfence" : : : "memory");
+        uint64_t count = bench_rdpmc_read(timer->page);
+        __asm__ volatile ("lfence" : : : "memory");
+        return count;
+    }
+    return bench_tsc_start();
+}
+
+static inline uint64_t bench_timer_stop(const bench_timer_t *timer) {
+    if (timer->kind == BENCH_CLOCK_RDPMC) {
+        __asm__ volatile ("lfence" : : : "memory");
+        return bench_rdpmc_read(timer->page);
+    }
+    return bench_tsc_stop();
+}
+
+// 선택된 클럭 설명 출력 (대체된 경우 이유 포함)
+static inline void bench_timer_describe(const bench_timer_t *timer) {
+    printf("Cycle clock: %s", bench_clock_name(timer->kind));
+    if (timer->kind == BENCH_CLOCK_TSC) {
+        printf(" (fallback: %s)", timer->fallback_reason);
+    }
+    printf("\n");
+}
+
+#endif // BENCH_TIMER_H
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE     // CPU 고정 (bench_threads.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -6,53 +7,100 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <emmintrin.h>  // SSE2
 #include <immintrin.h>  // AVX
 #include <x86intrin.h>  // 추가 intrinsics
+#include "bench_stats.h"
+#include "bench_timer.h"
+#include "bench_perf.h"
+#include "bench_threads.h"
+#include "bench_cpu.h"
+#include "bench_pages.h"
 
 #define ITERATIONS 50000000
-#define WARMUP_ITERATIONS 5000000
+#define WARMUP_DIVISOR 10       // 웜업 반복 = 측정 반복 / WARMUP_DIVISOR
+#define SAMPLE_DIVISOR 50       // 샘플 1개 = 측정 반복 / SAMPLE_DIVISOR
+#define SCALING_DIVISOR 10      // 스케일링 라운드 1회 = 측정 반복 / SCALING_DIVISOR (스레드당)
+#define SCALING_ROUNDS 7        // 스레드 수마다 반복하는 라운드 수 (중앙값 사용)
 #define ENERGY_MEASUREMENT_DELAY_MS 100
-#define TEST_COUNT 25
 
 // MSR 레지스터 정의 (AMD Ryzen 전력 측정용)
 #define MSR_PWR_UNIT        0xC0010299
 #define MSR_CORE_ENERGY     0xC001029A
 #define MSR_PKG_ENERGY      0xC001029B
 
+// 측정 모드: 의존 체인(지연) / 독립 누산기(역처리량)
+typedef enum {
+    MODE_LATENCY = 0,
+    MODE_THROUGHPUT,
+    MODE_COUNT
+} kernel_mode_t;
+
+static const char *const mode_names[MODE_COUNT] = { "latency", "throughput" };
+
+#define CHAIN_LENGTH 8          // 지연 모드: 반복당 의존 명령어 수
+#define ACCUMULATORS 8          // 처리량 모드: 독립 누산기 수
+#define THROUGHPUT_ROUNDS 2     // 처리량 모드: 반복당 누산기 순회 횟수
+
 typedef struct {
-    char name[64];
-    double avg_cycles;
-    double avg_time_ns;
-    double energy_start;
-    double energy_end;
+    int measured;               // 0이면 해당 모드가 없는 커널 (n/a)
+    double cycles_per_op;       // 샘플 중앙값
+    double time_ns_per_op;
     double energy_consumed;
+    bench_clock_kind_t clock;   // 사이클을 측정한 클럭
+    bench_stats_t stats;        // 샘플별 cycles/op 통계
+    bench_perf_counts_t counters;   // 전체 샘플 누적 하드웨어 카운터
+    uint64_t counted_ops;           // 카운터 구간에서 실행된 명령어 수
+} mode_result_t;
+
+typedef struct {
+    char name[64];
+    const char *category;
+    unsigned missing_isa;       // 0이 아니면 이 CPU에서 쓸 수 없어 건너뛴 커널
+    mode_result_t mode[MODE_COUNT];
 } test_result_t;
 
-// RDTSC를 이용한 정확한 사이클 측정
-static inline uint64_t rdtsc(void) {
-    uint32_t hi, lo;
-    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
-    return ((uint64_t)lo) | (((uint64_t)hi) << 32);
-}
+// 커널 실행 컨텍스트 (setup에서 준비한 버퍼 등)
+typedef struct {
+    void *buffer;
+} kernel_ctx_t;
+
+typedef struct kernel_def kernel_def_t;
+
+typedef void (*kernel_setup_fn)(kernel_ctx_t *ctx, const kernel_def_t *kernel);
+typedef void (*kernel_body_fn)(kernel_ctx_t *ctx, uint64_t iterations);
+typedef void (*kernel_teardown_fn)(kernel_ctx_t *ctx);
+
+// 커널 레지스트리 항목: 이름, 카테고리, 모드별 본문, 준비/정리 함수
+struct kernel_def {
+    const char *name;
+    const char *category;
+    kernel_body_fn body[MODE_COUNT];    // NULL이면 해당 모드 측정 안 함
+    unsigned ops[MODE_COUNT];           // 본문 1회 반복당 측정 명령어 수
+    kernel_setup_fn setup;              // NULL이면 준비 없음
+    kernel_teardown_fn teardown;        // NULL이면 정리 없음
+    uint64_t iterations;                // 모드별 측정 명령어 수, 0이면 ITERATIONS
+    unsigned isa;                       // 필요한 bench_isa_t 비트, 0이면 x86-64 기본
+};
 
 // MSR 읽기 함수
 uint64_t read_msr(int cpu, uint32_t reg) {
     char path[32];
     int fd;
     uint64_t value;
-    
+
     snprintf(path, sizeof(path), "/dev/cpu/%d/msr", cpu);
     fd = open(path, O_RDONLY);
     if (fd < 0) {
         return 0;
     }
-    
+
     if (pread(fd, &value, sizeof(value), reg) != sizeof(value)) {
         close(fd);
         return 0;
     }
-    
+
     close(fd);
     return value;
 }
@@ -61,1028 +109,2228 @@ uint64_t read_msr(int cpu, uint32_t reg) {
 double get_energy_joules(int cpu) {
     uint64_t energy_raw = read_msr(cpu, MSR_CORE_ENERGY);
     uint64_t unit_raw = read_msr(cpu, MSR_PWR_UNIT);
-    
+
     if (energy_raw == 0 || unit_raw == 0) {
         return 0.0;
     }
-    
+
     double energy_unit = 1.0 / (1 << ((unit_raw >> 8) & 0x1F));
     return energy_raw * energy_unit;
 }
 
-// ============ 기본 산술 명령어 테스트 ============
+// ============ 커널 본문 생성 매크로 ============
+//
+// 피연산자는 모두 레지스터에 둔다 (volatile 스택 변수 없음).
+// 지연 모드: 하나의 레지스터에 CHAIN_LENGTH개의 명령어가 연쇄적으로 의존한다.
+// 처리량 모드: ACCUMULATORS개의 독립 누산기를 THROUGHPUT_ROUNDS번 순회한다.
+// OP(d)는 목적지 피연산자 d에 대한 명령어 1개의 어셈블리 문자열이며,
+// 소스 피연산자는 %[src]로 참조한다.
+//
+// 빌드는 x86-64 기본 ISA로 하고, SSE2를 넘는 커널은 TARGET_*으로 본문 함수만
+// 해당 ISA로 컴파일한다 (실행 여부는 레지스트리의 isa로 시작 시 판단).
 
-void test_add_instruction(test_result_t *result) {
-    strcpy(result->name, "ADD (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 1, b = 2, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("addl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+#define REP4(x) x x x x
+#define REP8(x) REP4(x) REP4(x)
+
+#define ACC8(OP) OP("%0") OP("%1") OP("%2") OP("%3") OP("%4") OP("%5") OP("%6") OP("%7")
+
+#define LATENCY_OPS     CHAIN_LENGTH
+#define THROUGHPUT_OPS  (ACCUMULATORS * THROUGHPUT_ROUNDS)
+
+#define TARGET_AVX      __attribute__((target("avx")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#define TARGET_FMA      __attribute__((target("avx,fma")))
+#define TARGET_AVX512   __attribute__((target("avx512f")))
+#define TARGET_POPCNT   __attribute__((target("popcnt")))
+#define TARGET_LZCNT    __attribute__((target("lzcnt")))
+
+#define DEFINE_TARGET_LATENCY_BODY(target, prefix, type, cons, init, src_init, OP) \
+static target void prefix##_latency(kernel_ctx_t *ctx, uint64_t n) { \
+    (void)ctx; \
+    type x = init, s = src_init; \
+    for (uint64_t i = 0; i < n; i++) { \
+        __asm__ volatile (REP8(OP("%0")) : "+" cons(x) : [src] cons(s) : "cc"); \
+    } \
+}
+
+#define DEFINE_TARGET_THROUGHPUT_BODY(target, prefix, type, cons, init, src_init, OP) \
+static target void prefix##_throughput(kernel_ctx_t *ctx, uint64_t n) { \
+    (void)ctx; \
+    type a0 = init, a1 = init, a2 = init, a3 = init; \
+    type a4 = init, a5 = init, a6 = init, a7 = init; \
+    type s = src_init; \
+    for (uint64_t i = 0; i < n; i++) { \
+        __asm__ volatile (ACC8(OP) ACC8(OP) \
+            : "+" cons(a0), "+" cons(a1), "+" cons(a2), "+" cons(a3), \
+              "+" cons(a4), "+" cons(a5), "+" cons(a6), "+" cons(a7) \
+            : [src] cons(s) : "cc"); \
+    } \
+}
+
+// 지연/처리량 모드에서 같은 명령어 형태를 쓰는 커널
+#define DEFINE_TARGET_KERNEL_BODIES(target, prefix, type, cons, init, src_init, OP) \
+    DEFINE_TARGET_LATENCY_BODY(target, prefix, type, cons, init, src_init, OP) \
+    DEFINE_TARGET_THROUGHPUT_BODY(target, prefix, type, cons, init, src_init, OP)
+
+// x86-64 기본 ISA 커널
+#define DEFINE_LATENCY_BODY(prefix, type, cons, init, src_init, OP) \
+    DEFINE_TARGET_LATENCY_BODY(, prefix, type, cons, init, src_init, OP)
+#define DEFINE_THROUGHPUT_BODY(prefix, type, cons, init, src_init, OP) \
+    DEFINE_TARGET_THROUGHPUT_BODY(, prefix, type, cons, init, src_init, OP)
+#define DEFINE_KERNEL_BODIES(prefix, type, cons, init, src_init, OP) \
+    DEFINE_TARGET_KERNEL_BODIES(, prefix, type, cons, init, src_init, OP)
+
+// ============ 기본 산술 명령어 커널 ============
+
+#define ADD_OP(d)   "addl %[src], " d "\n\t"
+#define SUB_OP(d)   "subl %[src], " d "\n\t"
+#define IMUL_OP(d)  "imull %[src], " d "\n\t"
+
+DEFINE_KERNEL_BODIES(add,  uint32_t, "r", 1,   2,   ADD_OP)
+DEFINE_KERNEL_BODIES(sub,  uint32_t, "r", 100, 1,   SUB_OP)
+DEFINE_KERNEL_BODIES(imul, uint32_t, "r", 123, 457, IMUL_OP)
+
+// DIV는 edx:eax를 고정으로 쓰므로 별도 본문을 둔다.
+// 지연 모드는 몫을 다음 피제수로 이어 쓴다. 제수가 1이라 몫이 피제수와 같아서
+// 크기를 유지하는 명령어 없이 체인에는 divl만 남는다 (xorl edx는 zero idiom이라
+// rename 단계에서 처리되어 지연에 더해지지 않는다).
+// 처리량 모드는 매번 같은 피제수를 새로 적재해 나눗셈끼리 독립적이다.
+// DIV 지연은 몫의 비트 수에 따라 달라지므로 두 모드 모두 같은 몫(1000000)을 쓴다.
+#define DIV_CHAIN_OP(d) "xorl %%edx, %%edx\n\tdivl %[src]\n\t"
+#define DIV_INDEP_OP(d) "movl %[dividend], %%eax\n\txorl %%edx, %%edx\n\tdivl %[src]\n\t"
+
+static void div_latency(kernel_ctx_t *ctx, uint64_t n) {
+    (void)ctx;
+    uint32_t x = 1000000, s = 1;
+    for (uint64_t i = 0; i < n; i++) {
+        __asm__ volatile (REP8(DIV_CHAIN_OP("")) : "+a"(x) : [src] "r"(s) : "edx", "cc");
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("addl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+}
+
+static void div_throughput(kernel_ctx_t *ctx, uint64_t n) {
+    (void)ctx;
+    uint32_t dividend = 1000000, s = 1;
+    for (uint64_t i = 0; i < n; i++) {
+        __asm__ volatile (REP8(DIV_INDEP_OP("")) REP8(DIV_INDEP_OP(""))
+                          : : [src] "r"(s), [dividend] "r"(dividend) : "eax", "edx", "cc");
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
 }
 
-void test_sub_instruction(test_result_t *result) {
-    strcpy(result->name, "SUB (32-bit)");
-    
+// ============ 논리 연산 명령어 커널 ============
+
+#define AND_OP(d)   "andl %[src], " d "\n\t"
+#define OR_OP(d)    "orl %[src], " d "\n\t"
+#define XOR_OP(d)   "xorl %[src], " d "\n\t"
+
+DEFINE_KERNEL_BODIES(and, uint32_t, "r", 0xAAAAAAAA, 0xFFFF5555, AND_OP)
+DEFINE_KERNEL_BODIES(or,  uint32_t, "r", 0xAAAAAAAA, 0x55555555, OR_OP)
+DEFINE_KERNEL_BODIES(xor, uint32_t, "r", 0xAAAAAAAA, 0x55555555, XOR_OP)
+
+// ============ 시프트 연산 명령어 커널 ============
+
+#define SHL_OP(d)   "shll $4, " d "\n\t"
+#define SHR_OP(d)   "shrl $4, " d "\n\t"
+
+DEFINE_KERNEL_BODIES(shl, uint32_t, "r", 0x12345678, 0, SHL_OP)
+DEFINE_KERNEL_BODIES(shr, uint32_t, "r", 0x87654321, 0, SHR_OP)
+
+// ============ 메모리 이동 명령어 커널 ============
+
+// MOV 체인은 자기 자신으로의 이동이 제거될 수 있으므로 두 레지스터를 오간다.
+// 지연 모드의 명령어 1개 = movl 2개이므로 ops는 LATENCY_OPS * 2로 등록한다.
+#define MOV_CHAIN_OP(d) "movl " d ", %[src]\n\tmovl %[src], " d "\n\t"
+#define MOV_OP(d)       "movl %[src], " d "\n\t"
+
+static void mov_latency(kernel_ctx_t *ctx, uint64_t n) {
+    (void)ctx;
+    uint32_t x = 0x12345678, t = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        __asm__ volatile (REP8(MOV_CHAIN_OP("%0")) : "+r"(x), [src] "+r"(t));
+    }
+}
+
+DEFINE_THROUGHPUT_BODY(mov, uint32_t, "r", 0, 0x12345678, MOV_OP)
+
+// CMP는 플래그만 쓰므로 의존 체인을 만들 수 없다 (처리량만 측정)
+#define CMP_OP(d)   "cmpl %[src], " d "\n\t"
+
+DEFINE_THROUGHPUT_BODY(cmp, uint32_t, "r", 100, 200, CMP_OP)
+
+// ============ SSE/SSE2 명령어 커널 ============
+
+#define PADDQ_OP(d) "paddq %[src], " d "\n\t"
+#define ADDPS_OP(d) "addps %[src], " d "\n\t"
+#define MULPS_OP(d) "mulps %[src], " d "\n\t"
+
+DEFINE_KERNEL_BODIES(sse_paddq, __m128i, "x", _mm_set1_epi64x(0x1111111111111111LL),
+                     _mm_set1_epi64x(3), PADDQ_OP)
+DEFINE_KERNEL_BODIES(sse_addps, __m128, "x", _mm_set1_ps(1.0f), _mm_set1_ps(0.5f), ADDPS_OP)
+DEFINE_KERNEL_BODIES(sse_mulps, __m128, "x", _mm_set1_ps(1.1f), _mm_set1_ps(1.0f), MULPS_OP)
+
+// ============ AVX/AVX2 명령어 커널 ============
+
+#define VPADDQ_OP(d) "vpaddq %[src], " d ", " d "\n\t"
+#define VADDPS_OP(d) "vaddps %[src], " d ", " d "\n\t"
+#define VMULPS_OP(d) "vmulps %[src], " d ", " d "\n\t"
+
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX2, avx_vpaddq, __m256i, "x",
+                            _mm256_set1_epi64x(0x1111111111111111LL), _mm256_set1_epi64x(3), VPADDQ_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, avx_vaddps, __m256, "x", _mm256_set1_ps(1.0f),
+                            _mm256_set1_ps(0.5f), VADDPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, avx_vmulps, __m256, "x", _mm256_set1_ps(1.1f),
+                            _mm256_set1_ps(1.0f), VMULPS_OP)
+
+// ============ 벡터 폭 비교 (128/256/512-bit) ============
+//
+// 같은 명령어를 xmm(VEX)/ymm/zmm으로 재서 폭에 따른 지연/처리량 차이를 본다.
+// 256-bit는 위의 AVX 커널과 같은 본문이다. zmm은 "v" 제약으로 zmm0-31을 쓴다.
+
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, vpaddq_128, __m128i, "x",
+                            _mm_set1_epi64x(0x1111111111111111LL), _mm_set1_epi64x(3), VPADDQ_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, vpaddq_512, __m512i, "v",
+                            _mm512_set1_epi64(0x1111111111111111LL), _mm512_set1_epi64(3), VPADDQ_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, vaddps_128, __m128, "x", _mm_set1_ps(1.0f),
+                            _mm_set1_ps(0.5f), VADDPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, vaddps_512, __m512, "v", _mm512_set1_ps(1.0f),
+                            _mm512_set1_ps(0.5f), VADDPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, vmulps_128, __m128, "x", _mm_set1_ps(1.1f),
+                            _mm_set1_ps(1.0f), VMULPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, vmulps_512, __m512, "v", _mm512_set1_ps(1.1f),
+                            _mm512_set1_ps(1.0f), VMULPS_OP)
+
+// ============ FMA 명령어 커널 ============
+
+// d += src * src: 누산기 d에만 의존하므로 지연 모드는 FMA 지연 그대로다
+#define VFMADD231PS_OP(d) "vfmadd231ps %[src], %[src], " d "\n\t"
+#define VFMADD231PD_OP(d) "vfmadd231pd %[src], %[src], " d "\n\t"
+
+DEFINE_TARGET_KERNEL_BODIES(TARGET_FMA, fma_ps_128, __m128, "x", _mm_set1_ps(1.0f),
+                            _mm_set1_ps(1e-3f), VFMADD231PS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_FMA, fma_ps_256, __m256, "x", _mm256_set1_ps(1.0f),
+                            _mm256_set1_ps(1e-3f), VFMADD231PS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, fma_ps_512, __m512, "v", _mm512_set1_ps(1.0f),
+                            _mm512_set1_ps(1e-3f), VFMADD231PS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_FMA, fma_pd_256, __m256d, "x", _mm256_set1_pd(1.0),
+                            _mm256_set1_pd(1e-3), VFMADD231PD_OP)
+
+// ============ 벡터 나눗셈/제곱근 커널 ============
+//
+// 나눗셈은 1에 가까운 제수로 나눠 값이 비정규수/무한대로 가지 않게 한다.
+// 제곱근 지연 모드는 결과의 제곱근을 다시 구하고 (값은 1.0으로 수렴),
+// 처리량 모드는 고정 소스의 제곱근을 각 누산기에 쓴다.
+// 128-bit는 SSE2 인코딩이라 모든 x86-64에서 실행된다.
+
+#define DIVPS_OP(d)         "divps %[src], " d "\n\t"
+#define DIVPD_OP(d)         "divpd %[src], " d "\n\t"
+#define VDIVPS_OP(d)        "vdivps %[src], " d ", " d "\n\t"
+#define VDIVPD_OP(d)        "vdivpd %[src], " d ", " d "\n\t"
+#define SQRTPS_CHAIN_OP(d)  "sqrtps " d ", " d "\n\t"
+#define SQRTPS_OP(d)        "sqrtps %[src], " d "\n\t"
+#define SQRTPD_CHAIN_OP(d)  "sqrtpd " d ", " d "\n\t"
+#define SQRTPD_OP(d)        "sqrtpd %[src], " d "\n\t"
+#define VSQRTPS_CHAIN_OP(d) "vsqrtps " d ", " d "\n\t"
+#define VSQRTPS_OP(d)       "vsqrtps %[src], " d "\n\t"
+#define VSQRTPD_CHAIN_OP(d) "vsqrtpd " d ", " d "\n\t"
+#define VSQRTPD_OP(d)       "vsqrtpd %[src], " d "\n\t"
+
+DEFINE_KERNEL_BODIES(divps_128, __m128, "x", _mm_set1_ps(1.5f), _mm_set1_ps(0.999999f), DIVPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, divps_256, __m256, "x", _mm256_set1_ps(1.5f),
+                            _mm256_set1_ps(0.999999f), VDIVPS_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, divps_512, __m512, "v", _mm512_set1_ps(1.5f),
+                            _mm512_set1_ps(0.999999f), VDIVPS_OP)
+DEFINE_KERNEL_BODIES(divpd_128, __m128d, "x", _mm_set1_pd(1.5), _mm_set1_pd(0.9999999999),
+                     DIVPD_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX, divpd_256, __m256d, "x", _mm256_set1_pd(1.5),
+                            _mm256_set1_pd(0.9999999999), VDIVPD_OP)
+DEFINE_TARGET_KERNEL_BODIES(TARGET_AVX512, divpd_512, __m512d, "v", _mm512_set1_pd(1.5),
+                            _mm512_set1_pd(0.9999999999), VDIVPD_OP)
+
+DEFINE_LATENCY_BODY(sqrtps_128, __m128, "x", _mm_set1_ps(1e30f), _mm_setzero_ps(), SQRTPS_CHAIN_OP)
+DEFINE_THROUGHPUT_BODY(sqrtps_128, __m128, "x", _mm_setzero_ps(), _mm_set1_ps(2.0f), SQRTPS_OP)
+DEFINE_TARGET_LATENCY_BODY(TARGET_AVX, sqrtps_256, __m256, "x", _mm256_set1_ps(1e30f),
+                           _mm256_setzero_ps(), VSQRTPS_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_AVX, sqrtps_256, __m256, "x", _mm256_setzero_ps(),
+                              _mm256_set1_ps(2.0f), VSQRTPS_OP)
+DEFINE_TARGET_LATENCY_BODY(TARGET_AVX512, sqrtps_512, __m512, "v", _mm512_set1_ps(1e30f),
+                           _mm512_setzero_ps(), VSQRTPS_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_AVX512, sqrtps_512, __m512, "v", _mm512_setzero_ps(),
+                              _mm512_set1_ps(2.0f), VSQRTPS_OP)
+DEFINE_LATENCY_BODY(sqrtpd_128, __m128d, "x", _mm_set1_pd(1e300), _mm_setzero_pd(), SQRTPD_CHAIN_OP)
+DEFINE_THROUGHPUT_BODY(sqrtpd_128, __m128d, "x", _mm_setzero_pd(), _mm_set1_pd(2.0), SQRTPD_OP)
+DEFINE_TARGET_LATENCY_BODY(TARGET_AVX, sqrtpd_256, __m256d, "x", _mm256_set1_pd(1e300),
+                           _mm256_setzero_pd(), VSQRTPD_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_AVX, sqrtpd_256, __m256d, "x", _mm256_setzero_pd(),
+                              _mm256_set1_pd(2.0), VSQRTPD_OP)
+DEFINE_TARGET_LATENCY_BODY(TARGET_AVX512, sqrtpd_512, __m512d, "v", _mm512_set1_pd(1e300),
+                           _mm512_setzero_pd(), VSQRTPD_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_AVX512, sqrtpd_512, __m512d, "v", _mm512_setzero_pd(),
+                              _mm512_set1_pd(2.0), VSQRTPD_OP)
+
+// ============ 비트 조작 명령어 커널 ============
+
+// 지연 모드는 결과를 다시 입력으로 쓰고, 처리량 모드는 고정 소스를 읽는다
+#define POPCNT_CHAIN_OP(d)  "popcntq " d ", " d "\n\t"
+#define POPCNT_OP(d)        "popcntq %[src], " d "\n\t"
+#define LZCNT_CHAIN_OP(d)   "lzcntq " d ", " d "\n\t"
+#define LZCNT_OP(d)         "lzcntq %[src], " d "\n\t"
+
+DEFINE_TARGET_LATENCY_BODY(TARGET_POPCNT, popcnt, uint64_t, "r", 0x123456789ABCDEFULL, 0,
+                           POPCNT_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_POPCNT, popcnt, uint64_t, "r", 0, 0x123456789ABCDEFULL,
+                              POPCNT_OP)
+DEFINE_TARGET_LATENCY_BODY(TARGET_LZCNT, lzcnt, uint64_t, "r", 0x0000123456789ABCULL, 0,
+                           LZCNT_CHAIN_OP)
+DEFINE_TARGET_THROUGHPUT_BODY(TARGET_LZCNT, lzcnt, uint64_t, "r", 0, 0x0000123456789ABCULL,
+                              LZCNT_OP)
+
+// ============ 분기 명령어 커널 ============
+
+// 분기는 항상 taken이므로 체인이 없다 (처리량만 측정)
+#define BRANCH_OP(d) "cmpl $0, " d "\n\tje 1f\n\tincl " d "\n\t1:\n\t"
+
+DEFINE_THROUGHPUT_BODY(branch, uint32_t, "r", 0, 0, BRANCH_OP)
+
+// ============ 커널 레지스트리 ============
+
+#define CAT_ARITH   "Basic Arithmetic"
+#define CAT_LOGIC   "Logical Operations"
+#define CAT_SHIFT   "Shift Operations"
+#define CAT_BASIC   "Basic Instructions"
+#define CAT_SSE     "SSE Instructions"
+#define CAT_WIDTH   "Vector Width"
+#define CAT_FMA     "FMA Instructions"
+#define CAT_DIVSQRT "Vector Divide/Sqrt"
+#define CAT_BITS    "Bit Manipulation"
+#define CAT_BRANCH  "Branch Instructions"
+
+// 지연/처리량 본문을 모두 가진 커널 (isa: 실행에 필요한 bench_isa_t 비트)
+#define ISA_KERNEL(label, cat, prefix, required) \
+    { .name = label, .category = cat, \
+      .body = { prefix##_latency, prefix##_throughput }, \
+      .ops = { LATENCY_OPS, THROUGHPUT_OPS }, .isa = required }
+
+#define KERNEL(label, cat, prefix) ISA_KERNEL(label, cat, prefix, 0)
+
+// 처리량 본문만 가진 커널
+#define THROUGHPUT_KERNEL(label, cat, prefix) \
+    { .name = label, .category = cat, \
+      .body = { NULL, prefix##_throughput }, \
+      .ops = { 0, THROUGHPUT_OPS } }
+
+// 같은 카테고리의 커널은 연속해서 등록한다 (카테고리 순서 = 출력 순서)
+static const kernel_def_t kernels[] = {
+    KERNEL("ADD (32-bit)",    CAT_ARITH, add),
+    KERNEL("SUB (32-bit)",    CAT_ARITH, sub),
+    KERNEL("IMUL (32-bit)",   CAT_ARITH, imul),
+    KERNEL("DIV (32-bit)",    CAT_ARITH, div),
+
+    KERNEL("AND (32-bit)",    CAT_LOGIC, and),
+    KERNEL("OR (32-bit)",     CAT_LOGIC, or),
+    KERNEL("XOR (32-bit)",    CAT_LOGIC, xor),
+
+    KERNEL("SHL (32-bit)",    CAT_SHIFT, shl),
+    KERNEL("SHR (32-bit)",    CAT_SHIFT, shr),
+
+    { .name = "MOV (register)", .category = CAT_BASIC,
+      .body = { mov_latency, mov_throughput }, .ops = { LATENCY_OPS * 2, THROUGHPUT_OPS } },
+    THROUGHPUT_KERNEL("CMP (32-bit)", CAT_BASIC, cmp),
+
+    ISA_KERNEL("SSE2 PADDQ",      CAT_SSE, sse_paddq, BENCH_ISA_SSE2),
+    ISA_KERNEL("SSE ADDPS",       CAT_SSE, sse_addps, BENCH_ISA_SSE2),
+    ISA_KERNEL("SSE MULPS",       CAT_SSE, sse_mulps, BENCH_ISA_SSE2),
+
+    ISA_KERNEL("VPADDQ (128)",    CAT_WIDTH, vpaddq_128, BENCH_ISA_AVX),
+    ISA_KERNEL("VPADDQ (256)",    CAT_WIDTH, avx_vpaddq, BENCH_ISA_AVX2),
+    ISA_KERNEL("VPADDQ (512)",    CAT_WIDTH, vpaddq_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("VADDPS (128)",    CAT_WIDTH, vaddps_128, BENCH_ISA_AVX),
+    ISA_KERNEL("VADDPS (256)",    CAT_WIDTH, avx_vaddps, BENCH_ISA_AVX),
+    ISA_KERNEL("VADDPS (512)",    CAT_WIDTH, vaddps_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("VMULPS (128)",    CAT_WIDTH, vmulps_128, BENCH_ISA_AVX),
+    ISA_KERNEL("VMULPS (256)",    CAT_WIDTH, avx_vmulps, BENCH_ISA_AVX),
+    ISA_KERNEL("VMULPS (512)",    CAT_WIDTH, vmulps_512, BENCH_ISA_AVX512F),
+
+    ISA_KERNEL("VFMADD231PS (128)", CAT_FMA, fma_ps_128, BENCH_ISA_FMA),
+    ISA_KERNEL("VFMADD231PS (256)", CAT_FMA, fma_ps_256, BENCH_ISA_FMA),
+    ISA_KERNEL("VFMADD231PS (512)", CAT_FMA, fma_ps_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("VFMADD231PD (256)", CAT_FMA, fma_pd_256, BENCH_ISA_FMA),
+
+    ISA_KERNEL("DIVPS (128)",     CAT_DIVSQRT, divps_128, BENCH_ISA_SSE2),
+    ISA_KERNEL("VDIVPS (256)",    CAT_DIVSQRT, divps_256, BENCH_ISA_AVX),
+    ISA_KERNEL("VDIVPS (512)",    CAT_DIVSQRT, divps_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("DIVPD (128)",     CAT_DIVSQRT, divpd_128, BENCH_ISA_SSE2),
+    ISA_KERNEL("VDIVPD (256)",    CAT_DIVSQRT, divpd_256, BENCH_ISA_AVX),
+    ISA_KERNEL("VDIVPD (512)",    CAT_DIVSQRT, divpd_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("SQRTPS (128)",    CAT_DIVSQRT, sqrtps_128, BENCH_ISA_SSE2),
+    ISA_KERNEL("VSQRTPS (256)",   CAT_DIVSQRT, sqrtps_256, BENCH_ISA_AVX),
+    ISA_KERNEL("VSQRTPS (512)",   CAT_DIVSQRT, sqrtps_512, BENCH_ISA_AVX512F),
+    ISA_KERNEL("SQRTPD (128)",    CAT_DIVSQRT, sqrtpd_128, BENCH_ISA_SSE2),
+    ISA_KERNEL("VSQRTPD (256)",   CAT_DIVSQRT, sqrtpd_256, BENCH_ISA_AVX),
+    ISA_KERNEL("VSQRTPD (512)",   CAT_DIVSQRT, sqrtpd_512, BENCH_ISA_AVX512F),
+
+    ISA_KERNEL("POPCNT (64-bit)", CAT_BITS, popcnt, BENCH_ISA_POPCNT),
+    ISA_KERNEL("LZCNT (64-bit)",  CAT_BITS, lzcnt, BENCH_ISA_LZCNT),
+
+    THROUGHPUT_KERNEL("Branch (taken)", CAT_BRANCH, branch),
+};
+
+#define TEST_COUNT ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+// ============ 공통 측정 엔진 ============
+
+static bench_sampling_config_t sampling = BENCH_SAMPLING_DEFAULTS;
+static bench_timer_t timer;     // 메인 스레드의 사이클 클럭
+static bench_cpu_t cpu;         // 시작 시 감지한 ISA (--no-isa로 끈 것 제외)
+static int force_tsc = 0;       // --tsc: perf 카운터 대신 TSC 사용
+static int scaling_mode = 0;    // --scaling: 1..N 스레드 스케일링 곡선 측정
+static int bandwidth_mode = 0;  // --bandwidth: STREAM 대역폭 측정
+static int branch_mode = 0;     // --branch: 분기 예측 패턴/간접 분기/BTB 측정
+static int tlb_mode = 0;        // --tlb: 페이지 크기별 TLB 스윕
+static int c2c_mode = 0;        // --c2c: 코어 간 캐시 라인 왕복 지연 행렬
+static int max_threads = 0;     // --threads: 스케일링/대역폭 최대 스레드 수, c2c 행렬 CPU 수 (0이면 전체 CPU)
+
+// 한 커널/모드의 샘플 측정 상태
+typedef struct {
+    const kernel_def_t *kernel;
+    kernel_ctx_t *ctx;
+    const bench_perf_t *perf;   // 커널별 카운터 그룹
+    kernel_mode_t mode;
+    uint64_t loops;             // 샘플당 본문 반복 횟수
+    uint64_t ops;               // 샘플당 측정 명령어 수
+    double total_ns;            // 전체 샘플 누적 시간
+    uint64_t total_ops;         // 전체 샘플 누적 명령어 수
+} mode_sampler_t;
+
+static double sample_mode(void *arg) {
+    mode_sampler_t *sampler = arg;
     uint64_t start_cycles, end_cycles;
     struct timespec start_time, end_time;
-    volatile uint32_t a = 100, b = 1, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("subl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
-    }
-    
-    result->energy_start = get_energy_joules(0);
+
     clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("subl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
-    }
-    
-    end_cycles = rdtsc();
+    bench_perf_start(sampler->perf);
+    start_cycles = bench_timer_start(&timer);
+
+    sampler->kernel->body[sampler->mode](sampler->ctx, sampler->loops);
+
+    end_cycles = bench_timer_stop(&timer);
+    bench_perf_stop(sampler->perf);
     clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+
+    sampler->total_ns += (end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                         (end_time.tv_nsec - start_time.tv_nsec);
+    sampler->total_ops += sampler->ops;
+    return (double)(end_cycles - start_cycles) / sampler->ops;
 }
 
-void test_mul_instruction(test_result_t *result) {
-    strcpy(result->name, "IMUL (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 123, b = 456, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("imull %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+// 모든 커널의 모든 모드가 동일한 웜업/샘플링/전력 측정을 거친다.
+// 본문은 반복당 ops개의 명령어를 실행하므로, 샘플마다 약
+// iterations / SAMPLE_DIVISOR개의 명령어가 실행되도록 반복 횟수를 나누고
+// 결과는 명령어 1개당 값으로 보고한다.
+// 하드웨어 카운터는 샘플의 본문 실행 구간에서만 켜지고 모드 단위로 누적된다.
+static void measure_mode(const kernel_def_t *kernel, kernel_ctx_t *ctx, const bench_perf_t *perf,
+                         kernel_mode_t mode, mode_result_t *result) {
+    uint64_t iterations = kernel->iterations ? kernel->iterations : ITERATIONS;
+    uint64_t loops = iterations / kernel->ops[mode];
+    mode_sampler_t sampler = {
+        .kernel = kernel, .ctx = ctx, .perf = perf, .mode = mode,
+        .loops = loops / SAMPLE_DIVISOR > 0 ? loops / SAMPLE_DIVISOR : 1,
+    };
+    double energy_start, energy_end;
+
+    sampler.ops = sampler.loops * kernel->ops[mode];
+
+    kernel->body[mode](ctx, loops / WARMUP_DIVISOR);
+
+    energy_start = get_energy_joules(0);
+    bench_perf_reset(perf);
+    bench_sample(&sampling, sample_mode, &sampler, &result->stats);
+    bench_perf_read(perf, &result->counters);
+    energy_end = get_energy_joules(0);
+
+    result->measured = 1;
+    result->clock = timer.kind;
+    result->cycles_per_op = result->stats.median;
+    result->time_ns_per_op = sampler.total_ns / sampler.total_ops;
+    result->energy_consumed = energy_end - energy_start;
+    result->counted_ops = sampler.total_ops;
+}
+
+void run_kernel(const kernel_def_t *kernel, test_result_t *result) {
+    kernel_ctx_t ctx = {0};
+    bench_perf_t perf;
+
+    memset(result, 0, sizeof(*result));
+    snprintf(result->name, sizeof(result->name), "%s", kernel->name);
+    result->category = kernel->category;
+
+    if (kernel->setup) {
+        kernel->setup(&ctx, kernel);
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("imull %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+
+    // 커널마다 새 카운터 그룹을 열어 다른 커널/준비 코드와 섞이지 않게 한다
+    bench_perf_open(&perf);
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        if (kernel->body[mode]) {
+            measure_mode(kernel, &ctx, &perf, mode, &result->mode[mode]);
+        }
+    }
+    bench_perf_close(&perf);
+
+    if (kernel->teardown) {
+        kernel->teardown(&ctx);
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
 }
 
-void test_div_instruction(test_result_t *result) {
-    strcpy(result->name, "DIV (32-bit)");
-    
+// ============ 멀티코어 스케일링 ============
+//
+// 같은 커널을 1..N개의 고정 스레드에서 동시에 실행한다. 각 스레드는 자기
+// 컨텍스트(메모리 커널이면 자기 버퍼)와 자기 사이클 클럭을 가지며,
+// 라운드마다 배리어에서 함께 출발한다. 라운드의 집계 처리량은
+// (스레드 수 x 명령어 수) / 가장 늦게 끝난 스레드의 시간이다.
+
+typedef struct {
+    const kernel_def_t *kernel;
+    kernel_mode_t mode;
+    uint64_t loops;             // 라운드당 스레드별 본문 반복 횟수
+    uint64_t ops;               // 라운드당 스레드별 측정 명령어 수
+    bench_clock_kind_t clock;
+    double elapsed_ns[BENCH_MAX_CPUS][SCALING_ROUNDS];
+    double cycles[BENCH_MAX_CPUS][SCALING_ROUNDS];
+} scaling_run_t;
+
+static void scaling_worker(bench_team_t *team, int index, void *arg) {
+    scaling_run_t *run = arg;
+    const kernel_def_t *kernel = run->kernel;
+    kernel_ctx_t ctx = {0};
+    bench_timer_t thread_timer;     // perf 카운터는 스레드별로 연다
+
+    bench_timer_init(&thread_timer, force_tsc);
+    if (index == 0) {
+        run->clock = thread_timer.kind;
+    }
+    if (kernel->setup) {
+        kernel->setup(&ctx, kernel);
+    }
+    kernel->body[run->mode](&ctx, run->loops);
+
+    for (int r = 0; r < SCALING_ROUNDS; r++) {
+        struct timespec start_time, end_time;
+        uint64_t start_cycles, end_cycles;
+
+        bench_team_sync(team);
+        clock_gettime(CLOCK_MONOTONIC, &start_time);
+        start_cycles = bench_timer_start(&thread_timer);
+
+        kernel->body[run->mode](&ctx, run->loops);
+
+        end_cycles = bench_timer_stop(&thread_timer);
+        clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+        run->elapsed_ns[index][r] = (end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                                    (end_time.tv_nsec - start_time.tv_nsec);
+        run->cycles[index][r] = (double)(end_cycles - start_cycles);
+    }
+
+    if (kernel->teardown) {
+        kernel->teardown(&ctx);
+    }
+    bench_timer_close(&thread_timer);
+}
+
+// values를 정렬해 중앙값을 반환
+static double median_of(double *values, int n) {
+    qsort(values, n, sizeof(double), bench_compare_double);
+    return bench_percentile(values, n, 50.0);
+}
+
+// 한 커널의 스케일링 곡선: 스레드 수별 집계/스레드별 처리량 (Gop/s = op/ns)
+static void run_kernel_scaling(const kernel_def_t *kernel, const bench_topology_t *topo,
+                               int threads_limit) {
+    kernel_mode_t mode = kernel->body[MODE_THROUGHPUT] ? MODE_THROUGHPUT : MODE_LATENCY;
+    uint64_t iterations = kernel->iterations ? kernel->iterations : ITERATIONS;
+    uint64_t loops = iterations / kernel->ops[mode] / SCALING_DIVISOR;
+    scaling_run_t *run = calloc(1, sizeof(*run));
+    double single_thread = 0.0;     // 기준 행의 스레드당 집계 처리량 (0이면 아직 없음)
+
+    run->kernel = kernel;
+    run->mode = mode;
+    run->loops = loops > 0 ? loops : 1;
+    run->ops = run->loops * kernel->ops[mode];
+
+    printf("\nScaling: %s [%s]\n", kernel->name, mode_names[mode]);
+    printf("%7s %5s %12s %8s %7s %12s %12s %10s\n", "Threads", "CPU", "Agg(Gop/s)", "Speedup",
+           "Eff(%)", "Thr min", "Thr avg", "Cycles/op");
+
+    for (int n = 1; n <= threads_limit; n++) {
+        double aggregate[SCALING_ROUNDS], thread_rate, min_rate = 0.0, sum_rate = 0.0;
+        double sum_cycles = 0.0, agg;
+
+        if (bench_team_run(n, topo->cpus, scaling_worker, run) != 0) {
+            printf("%7d %4d%s   (could not pin threads, skipped)\n", n,
+                   topo->cpus[n - 1], topo->smt_sibling[n - 1] ? "*" : " ");
+            continue;
+        }
+
+        for (int r = 0; r < SCALING_ROUNDS; r++) {
+            double wall = 0.0;
+
+            for (int t = 0; t < n; t++) {
+                if (run->elapsed_ns[t][r] > wall) {
+                    wall = run->elapsed_ns[t][r];
+                }
+            }
+            aggregate[r] = (double)n * run->ops / wall;
+        }
+        agg = median_of(aggregate, SCALING_ROUNDS);
+        // n=1 고정에 실패했으면 처음 성공한 행을 스레드당 기준으로 삼는다
+        if (single_thread == 0.0) {
+            single_thread = agg / n;
+            if (n > 1) {
+                printf("        (no 1-thread row: speedup uses the %d-thread row divided by %d)\n", n, n);
+            }
+        }
+
+        for (int t = 0; t < n; t++) {
+            thread_rate = run->ops / median_of(run->elapsed_ns[t], SCALING_ROUNDS);
+            min_rate = t == 0 || thread_rate < min_rate ? thread_rate : min_rate;
+            sum_rate += thread_rate;
+            sum_cycles += median_of(run->cycles[t], SCALING_ROUNDS) / run->ops;
+        }
+
+        printf("%7d %4d%s %12.3f %8.2f %7.1f %12.3f %12.3f %10.3f\n", n,
+               topo->cpus[n - 1], topo->smt_sibling[n - 1] ? "*" : " ", agg,
+               agg / single_thread, agg / single_thread / n * 100.0,
+               min_rate, sum_rate / n, sum_cycles / n);
+        fflush(stdout);
+    }
+
+    free(run);
+}
+
+void run_scaling_suite(void) {
+    bench_topology_t topo;
+    int threads_limit;
+
+    bench_topology_detect(&topo);
+    threads_limit = max_threads > 0 && max_threads < topo.count ? max_threads : topo.count;
+
+    printf("Multi-core Scaling Test\n");
+    printf("=======================\n\n");
+    bench_topology_describe(&topo);
+    printf("Threads: 1..%d, %d rounds of %d ops per thread (median round reported)\n",
+           threads_limit, SCALING_ROUNDS, ITERATIONS / SCALING_DIVISOR);
+
+    for (int i = 0; i < TEST_COUNT; i++) {
+        if (!bench_cpu_has(&cpu, kernels[i].isa)) {
+            char isa[96];
+            printf("\nScaling: %s skipped (needs %s)\n", kernels[i].name,
+                   bench_isa_format(bench_cpu_missing(&cpu, kernels[i].isa), isa, sizeof(isa)));
+            continue;
+        }
+        run_kernel_scaling(&kernels[i], &topo, threads_limit);
+    }
+
+    printf("\nNotes:\n");
+    printf("- Agg: total ops of all threads / slowest thread's time per round, in Gop/s\n");
+    printf("- Thr min/avg: per-thread Gop/s, Cycles/op: per-thread average\n");
+    printf("- CPU marked * is an SMT sibling of an earlier CPU; from that row on threads\n"
+           "  share execution ports and per-thread throughput drops accordingly\n");
+}
+
+// ============ 코어 간 캐시 라인 왕복 지연 ============
+//
+// 논리 CPU 쌍마다 두 스레드를 고정하고 캐시 라인 하나에 있는 플래그를 주고받는다.
+// 스레드 0이 2k+1을 쓰면 스레드 1이 그 값을 보고 2k+2를 쓰고, 스레드 0이 다시 본다.
+// 왕복 1회에 라인이 두 코어 사이를 두 번 옮겨 다니므로 한 방향 전달은 대략 절반이다.
+// 쌍의 관계(SMT 형제, 같은 LLC/CCX, 같은 패키지의 다른 LLC, 다른 패키지)별로 모아
+// 작업을 넘겨줄 스레드를 어디에 둘지 고를 수 있게 한다.
+
+#define C2C_ROUND_TRIPS 20000           // 샘플당 왕복 횟수
+#define C2C_SAMPLES 7                   // 쌍마다 샘플 수 (중앙값 사용)
+
+typedef enum {
+    C2C_SMT = 0,                        // 같은 물리 코어
+    C2C_SAME_LLC,                       // 같은 마지막 레벨 캐시 (같은 CCX)
+    C2C_CROSS_LLC,                      // 같은 패키지, 다른 LLC (CCX 간)
+    C2C_CROSS_PACKAGE,
+    C2C_RELATION_COUNT
+} c2c_relation_t;
+
+static const char *const c2c_relation_names[C2C_RELATION_COUNT] = {
+    "SMT sibling", "same LLC", "cross LLC", "cross package"
+};
+
+typedef struct {
+    volatile uint64_t flag __attribute__((aligned(64)));
+    char pad[64 - sizeof(uint64_t)];    // 다른 필드가 같은 라인에 끼지 않게
+    double round_trip_ns[C2C_SAMPLES];
+} c2c_run_t;
+
+typedef struct {
+    int cpu;
+    int package;
+    int core;
+    int llc;
+} c2c_cpu_t;
+
+static void c2c_worker(bench_team_t *team, int index, void *arg) {
+    c2c_run_t *run = arg;
+
+    for (int s = 0; s < C2C_SAMPLES; s++) {
+        struct timespec start_time, end_time;
+
+        if (index == 0) {
+            __atomic_store_n(&run->flag, 0, __ATOMIC_RELAXED);
+        }
+        bench_team_sync(team);
+
+        if (index == 0) {
+            clock_gettime(CLOCK_MONOTONIC, &start_time);
+            for (uint64_t i = 0; i < C2C_ROUND_TRIPS; i++) {
+                __atomic_store_n(&run->flag, 2 * i + 1, __ATOMIC_RELEASE);
+                while (__atomic_load_n(&run->flag, __ATOMIC_ACQUIRE) != 2 * i + 2) {
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end_time);
+            run->round_trip_ns[s] = ((end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                                     (end_time.tv_nsec - start_time.tv_nsec)) / C2C_ROUND_TRIPS;
+        } else {
+            for (uint64_t i = 0; i < C2C_ROUND_TRIPS; i++) {
+                while (__atomic_load_n(&run->flag, __ATOMIC_ACQUIRE) != 2 * i + 1) {
+                }
+                __atomic_store_n(&run->flag, 2 * i + 2, __ATOMIC_RELEASE);
+            }
+        }
+        bench_team_sync(team);
+    }
+}
+
+// core/llc id를 모르면(-1) 같다고 단정하지 않고 더 먼 관계로 분류한다
+static c2c_relation_t c2c_relation(const c2c_cpu_t *a, const c2c_cpu_t *b) {
+    if (a->package != b->package) {
+        return C2C_CROSS_PACKAGE;
+    }
+    if (a->core >= 0 && a->core == b->core) {
+        return C2C_SMT;
+    }
+    return a->llc >= 0 && a->llc == b->llc ? C2C_SAME_LLC : C2C_CROSS_LLC;
+}
+
+static int compare_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+void run_c2c_suite(void) {
+    bench_topology_t topo;
+    c2c_cpu_t cpus[BENCH_MAX_CPUS];
+    int order[BENCH_MAX_CPUS];
+    c2c_run_t *run;
+    double *matrix, *by_relation[C2C_RELATION_COUNT];
+    int count[C2C_RELATION_COUNT] = {0};
+    int n;
+
+    bench_topology_detect(&topo);
+    n = max_threads > 0 && max_threads < topo.count ? max_threads : topo.count;
+
+    printf("Core-to-Core Cache Line Latency\n");
+    printf("===============================\n\n");
+    bench_topology_describe(&topo);
+    if (topo.count < 2) {
+        printf("Needs at least 2 CPUs in the affinity mask (have %d)\n", topo.count);
+        return;
+    }
+
+    // 행렬은 CPU 번호 순서로 보여준다 (--threads N이면 앞의 N개)
+    memcpy(order, topo.cpus, topo.count * sizeof(int));
+    qsort(order, topo.count, sizeof(int), compare_int);
+    for (int i = 0; i < n; i++) {
+        cpus[i].cpu = order[i];
+        cpus[i].package = bench_read_topology_id(order[i], "physical_package_id");
+        cpus[i].core = bench_read_topology_id(order[i], "core_id");
+        cpus[i].llc = bench_read_llc_id(order[i]);
+    }
+    printf("%d CPUs, %d pairs, %d samples of %d round trips per pair (median reported)\n\n",
+           n, n * (n - 1) / 2, C2C_SAMPLES, C2C_ROUND_TRIPS);
+
+    run = aligned_alloc(64, sizeof(*run));
+    matrix = calloc((size_t)n * n, sizeof(double));
+    for (int r = 0; r < C2C_RELATION_COUNT; r++) {
+        by_relation[r] = malloc((size_t)n * n * sizeof(double));
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            int pair[2] = { cpus[i].cpu, cpus[j].cpu };
+            c2c_relation_t relation = c2c_relation(&cpus[i], &cpus[j]);
+            double ns;
+
+            if (bench_team_run(2, pair, c2c_worker, run) != 0) {
+                matrix[i * n + j] = matrix[j * n + i] = -1.0;   // 고정 실패: n/a
+                continue;
+            }
+            ns = median_of(run->round_trip_ns, C2C_SAMPLES);
+            matrix[i * n + j] = matrix[j * n + i] = ns;
+            by_relation[relation][count[relation]++] = ns;
+        }
+        printf("\rMeasured %d/%d rows", i + 1, n);
+        fflush(stdout);
+    }
+
+    printf("\n\nRound-trip latency (ns, each pair measured once, lower CPU initiates):\n%5s", "CPU");
+    for (int j = 0; j < n; j++) {
+        printf(" %5d", cpus[j].cpu);
+    }
+    printf("\n");
+    for (int i = 0; i < n; i++) {
+        printf("%5d", cpus[i].cpu);
+        for (int j = 0; j < n; j++) {
+            if (i == j) {
+                printf(" %5s", "-");
+            } else if (matrix[i * n + j] < 0.0) {
+                printf(" %5s", "n/a");
+            } else {
+                printf(" %5.0f", matrix[i * n + j]);
+            }
+        }
+        printf("\n");
+    }
+
+    printf("\nBy relation (round trip ns; one-way handoff is about half):\n");
+    printf("%-14s %6s %9s %9s %9s\n", "Relation", "Pairs", "Min", "Median", "Max");
+    for (int r = 0; r < C2C_RELATION_COUNT; r++) {
+        if (count[r] == 0) {
+            continue;
+        }
+        qsort(by_relation[r], count[r], sizeof(double), bench_compare_double);
+        printf("%-14s %6d %9.1f %9.1f %9.1f\n", c2c_relation_names[r], count[r],
+               by_relation[r][0], bench_percentile(by_relation[r], count[r], 50.0),
+               by_relation[r][count[r] - 1]);
+    }
+
+    printf("\nNotes:\n");
+    printf("- Relations come from sysfs core_id, physical_package_id and the last-level cache id;\n"
+           "  on AMD the LLC is per CCX, so cross LLC means cross CCX\n");
+    printf("- Threads spin without pause, so both CPUs of a pair are fully busy while measuring\n");
+    printf("- n/a: the pair could not be pinned (see stderr)\n");
+
+    for (int r = 0; r < C2C_RELATION_COUNT; r++) {
+        free(by_relation[r]);
+    }
+    free(matrix);
+    free(run);
+}
+
+// ============ 메모리 지연 스윕 (랜덤 포인터 추적) ============
+//
+// 64B 캐시 라인마다 다음 라인의 주소를 저장하고, Sattolo 알고리즘으로 만든
+// 하나의 랜덤 순환 순열을 따라간다. 다음 주소가 이전 로드 결과에 의존하고
+// 순서가 무작위라 하드웨어 프리페처가 예측할 수 없다.
+// 작업 집합을 4KB부터 옥타브당 SWEEP_STEPS_PER_OCTAVE 단계로 키우며
+// 로드 1회당 지연을 측정하면 캐시 레벨마다 절벽이 나타난다.
+
+#define SWEEP_MIN_SIZE (4 * 1024)
+#define SWEEP_DEFAULT_MAX_MB 1024
+#define SWEEP_STEPS_PER_OCTAVE 4
+#define SWEEP_MAX_POINTS 160
+#define SWEEP_LINE_SIZE 64
+#define SWEEP_HOPS 100000           // 샘플당 포인터 추적 횟수
+#define SWEEP_WARMUP_MAX_HOPS (1 << 22)
+#define SWEEP_CLIFF_RATIO 1.3       // 인접 크기 간 지연 비율이 이보다 크면 절벽
+#define MAX_CACHE_LEVELS 8
+
+typedef struct {
+    size_t size;                // 작업 집합 크기 (bytes)
+    double cycles_per_load;     // 샘플 중앙값
+    double ns_per_load;
+    bench_stats_t stats;
+} sweep_point_t;
+
+typedef struct {
+    void **cursor;              // 샘플 간에 이어지는 추적 위치
+    double total_ns;
+    uint64_t total_hops;
+} chase_sampler_t;
+
+typedef struct {
+    int level;
+    size_t size;
+} cache_level_t;
+
+static size_t sweep_max_mb = SWEEP_DEFAULT_MAX_MB;     // --sweep-max: 0이면 스윕 생략
+static bench_page_kind_t sweep_pages = BENCH_PAGES_DEFAULT; // --pages: 지연 스윕 버퍼의 페이지 종류
+
+// 순환 순열을 hops번 따라간다 (8회씩 펼침, hops는 8의 배수)
+static void pointer_chase(void ***cursor, uint64_t hops) {
+    void **p = *cursor;
+    for (uint64_t i = 0; i < hops; i += 8) {
+        __asm__ volatile (REP8("movq (%0), %0\n\t") : "+r"(p) : : "memory");
+    }
+    *cursor = p;
+}
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// i번째 칸의 주소: stride 간격마다 라인 하나. stride가 라인보다 크면 칸마다 라인 위치를
+// 한 칸씩 밀어서 모든 칸이 같은 캐시 세트에 몰리지 않게 한다.
+static char *chase_slot(char *buffer, size_t i, size_t stride) {
+    return buffer + i * stride + (i * SWEEP_LINE_SIZE) % stride;
+}
+
+// buffer의 앞 slots개 칸을 하나의 랜덤 순환으로 연결 (Sattolo 알고리즘)
+static void build_chase_cycle(char *buffer, size_t slots, size_t stride, uint64_t *rng) {
+    for (size_t i = 0; i < slots; i++) {
+        *(void **)chase_slot(buffer, i, stride) = chase_slot(buffer, i, stride);
+    }
+    for (size_t i = slots - 1; i > 0; i--) {
+        void **a = (void **)chase_slot(buffer, i, stride);
+        void **b = (void **)chase_slot(buffer, xorshift64(rng) % i, stride);
+        void *tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+}
+
+static double sample_chase(void *arg) {
+    chase_sampler_t *sampler = arg;
     uint64_t start_cycles, end_cycles;
     struct timespec start_time, end_time;
-    volatile uint32_t a = 1000000, b = 7, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("movl %1, %%eax; xorl %%edx, %%edx; divl %2; movl %%eax, %0"
-                         : "=r"(c) : "r"(a), "r"(b) : "eax", "edx");
-    }
-    
-    result->energy_start = get_energy_joules(0);
+
     clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("movl %1, %%eax; xorl %%edx, %%edx; divl %2; movl %%eax, %0"
-                         : "=r"(c) : "r"(a), "r"(b) : "eax", "edx");
-    }
-    
-    end_cycles = rdtsc();
+    start_cycles = bench_timer_start(&timer);
+
+    pointer_chase(&sampler->cursor, SWEEP_HOPS);
+
+    end_cycles = bench_timer_stop(&timer);
     clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+
+    sampler->total_ns += (end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                         (end_time.tv_nsec - start_time.tv_nsec);
+    sampler->total_hops += SWEEP_HOPS;
+    return (double)(end_cycles - start_cycles) / SWEEP_HOPS;
 }
 
-// ============ 논리 연산 명령어 테스트 ============
+// slots개 칸의 순환을 만들고 한 바퀴(최대 SWEEP_WARMUP_MAX_HOPS) 웜업한 뒤 측정한다.
+// stats에는 load당 사이클, 반환값은 load당 ns.
+static double measure_chase(char *buffer, size_t slots, size_t stride, uint64_t *rng,
+                            bench_stats_t *stats) {
+    chase_sampler_t sampler = { .cursor = (void **)buffer };
 
-void test_and_instruction(test_result_t *result) {
-    strcpy(result->name, "AND (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0xAAAAAAAA, b = 0x55555555, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("andl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+    build_chase_cycle(buffer, slots, stride, rng);
+    pointer_chase(&sampler.cursor, slots < SWEEP_WARMUP_MAX_HOPS ?
+                  (slots + 7) & ~(uint64_t)7 : SWEEP_WARMUP_MAX_HOPS);
+    bench_sample(&sampling, sample_chase, &sampler, stats);
+    return sampler.total_ns / sampler.total_hops;
+}
+
+// 4KB..sweep_max_mb 스윕. 측정한 지점 수를 반환한다.
+// 최대 크기를 할당할 수 없으면 절반씩 줄여서 가능한 범위까지만 측정한다.
+// pages_desc에는 실제로 쓴 페이지 종류(--pages)와 huge page 비율을 남긴다.
+static int run_latency_sweep(sweep_point_t *points, char *pages_desc, size_t desc_size) {
+    size_t max_size = sweep_max_mb * 1024 * 1024;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    bench_pages_t pages;
+    int count = 0;
+
+    while (max_size >= SWEEP_MIN_SIZE && !bench_pages_alloc(&pages, max_size, sweep_pages)) {
+        max_size /= 2;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("andl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+    if (max_size < SWEEP_MIN_SIZE) {
+        return 0;
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-}
 
-void test_or_instruction(test_result_t *result) {
-    strcpy(result->name, "OR (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0xAAAAAAAA, b = 0x55555555, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("orl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+    for (int k = 0; count < SWEEP_MAX_POINTS; k++) {
+        size_t size = (size_t)(SWEEP_MIN_SIZE * pow(2.0, (double)k / SWEEP_STEPS_PER_OCTAVE));
+        size_t lines = size / SWEEP_LINE_SIZE;
+        sweep_point_t *point = &points[count];
+
+        if (size > max_size) {
+            break;
+        }
+        point->ns_per_load = measure_chase(pages.base, lines, SWEEP_LINE_SIZE, &rng, &point->stats);
+        point->size = lines * SWEEP_LINE_SIZE;
+        point->cycles_per_load = point->stats.median;
+        count++;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("orl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+
+    bench_pages_describe(&pages, pages_desc, desc_size);
+    bench_pages_free(&pages);
+    return count;
+}
+
+static void format_size(char *out, size_t len, size_t bytes) {
+    if (bytes >= 1024 * 1024 * 1024) {
+        snprintf(out, len, "%.2f GB", bytes / (1024.0 * 1024 * 1024));
+    } else if (bytes >= 1024 * 1024) {
+        snprintf(out, len, "%.1f MB", bytes / (1024.0 * 1024));
+    } else {
+        snprintf(out, len, "%.1f KB", bytes / 1024.0);
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
 }
 
-void test_xor_instruction(test_result_t *result) {
-    strcpy(result->name, "XOR (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0xAAAAAAAA, b = 0x55555555, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("xorl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+// sysfs에서 데이터/통합 캐시 크기를 읽는다. 읽은 레벨 수를 반환.
+static int read_cache_levels(cache_level_t *levels) {
+    int count = 0;
+
+    for (int index = 0; count < MAX_CACHE_LEVELS; index++) {
+        char path[96], type[32];
+        unsigned size_kb;
+        int level;
+        FILE *f;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        if (fscanf(f, "%d", &level) != 1) {
+            level = 0;
+        }
+        fclose(f);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        f = fopen(path, "r");
+        if (!f || fscanf(f, "%31s", type) != 1) {
+            type[0] = '\0';
+        }
+        if (f) {
+            fclose(f);
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        f = fopen(path, "r");
+        if (!f || fscanf(f, "%uK", &size_kb) != 1) {
+            size_kb = 0;
+        }
+        if (f) {
+            fclose(f);
+        }
+
+        if (level > 0 && size_kb > 0 && strcmp(type, "Instruction") != 0) {
+            levels[count].level = level;
+            levels[count].size = (size_t)size_kb * 1024;
+            count++;
+        }
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("xorl %1, %0" : "=r"(c) : "r"(b), "0"(a) : );
+    return count;
+}
+
+// 크기가 limit 이하인 마지막 스윕 지점 (없으면 -1)
+static int last_point_within(const sweep_point_t *points, int count, size_t limit) {
+    int found = -1;
+    for (int i = 0; i < count && points[i].size <= limit; i++) {
+        found = i;
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+    return found;
 }
 
-// ============ 시프트 연산 명령어 테스트 ============
+static void print_latency_sweep(const sweep_point_t *points, int count, const char *pages_desc) {
+    cache_level_t levels[MAX_CACHE_LEVELS];
+    int level_count = read_cache_levels(levels);
+    char size_label[32], next_label[32];
 
-void test_shl_instruction(test_result_t *result) {
-    strcpy(result->name, "SHL (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0x12345678, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("shll $4, %0" : "=r"(c) : "0"(a) : );
+    printf("\nMemory Latency Sweep (random pointer chase, %d B lines, * = CI target not reached):\n",
+           SWEEP_LINE_SIZE);
+    printf("Pages: %s\n", pages_desc);
+    printf("%12s %12s %10s %7s\n", "Size", "Cycles/load", "ns/load", "CI(%)");
+    for (int i = 0; i < count; i++) {
+        format_size(size_label, sizeof(size_label), points[i].size);
+        printf("%12s %12.3f %10.3f %6.2f%s\n", size_label, points[i].cycles_per_load,
+               points[i].ns_per_load, points[i].stats.ci_percent,
+               points[i].stats.converged ? "" : "*");
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("shll $4, %0" : "=r"(c) : "0"(a) : );
+
+    // 연속된 급증 구간을 하나의 절벽으로 묶어 출력
+    printf("\nLatency cliffs (>%.0f%% increase between neighbouring sizes):\n",
+           (SWEEP_CLIFF_RATIO - 1.0) * 100.0);
+    for (int i = 1; i < count; i++) {
+        int first = i;
+
+        if (points[i].cycles_per_load <= points[i - 1].cycles_per_load * SWEEP_CLIFF_RATIO) {
+            continue;
+        }
+        while (i + 1 < count &&
+               points[i + 1].cycles_per_load > points[i].cycles_per_load * SWEEP_CLIFF_RATIO) {
+            i++;
+        }
+        format_size(size_label, sizeof(size_label), points[first - 1].size);
+        format_size(next_label, sizeof(next_label), points[i].size);
+        printf("  %s -> %s: %.3f -> %.3f cycles\n", size_label, next_label,
+               points[first - 1].cycles_per_load, points[i].cycles_per_load);
+    }
+
+    // 각 캐시 레벨은 크기의 절반 안쪽 지점에서, RAM은 가장 큰 지점에서 읽는다.
+    // 스윕이 절반 크기까지 가지 못한 레벨은 더 작은 레벨의 값이 섞이므로 건너뛴다.
+    printf("\nCache Hierarchy Analysis:\n");
+    for (int l = 0; l < level_count; l++) {
+        int i = last_point_within(points, count, levels[l].size / 2);
+        char name[32];
+
+        format_size(size_label, sizeof(size_label), levels[l].size);
+        snprintf(name, sizeof(name), "L%d (%s)", levels[l].level, size_label);
+        if (count == 0 || levels[l].size / 2 > points[count - 1].size) {
+            format_size(next_label, sizeof(next_label), count > 0 ? points[count - 1].size : 0);
+            printf("%-18s not reached (sweep ends at %s, see --sweep-max)\n", name, next_label);
+            continue;
+        }
+        if (i < 0) {
+            continue;
+        }
+        printf("%-18s Access: %.3f cycles\n", name, points[i].cycles_per_load);
+    }
+    if (count > 0 && (level_count == 0 || points[count - 1].size > levels[level_count - 1].size * 2)) {
+        format_size(size_label, sizeof(size_label), points[count - 1].size);
+        snprintf(next_label, sizeof(next_label), "RAM (%s)", size_label);
+        printf("%-18s Access: %.3f cycles\n", next_label, points[count - 1].cycles_per_load);
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
 }
 
-void test_shr_instruction(test_result_t *result) {
-    strcpy(result->name, "SHR (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0x87654321, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("shrl $4, %0" : "=r"(c) : "0"(a) : );
+// ============ TLB / huge page ============
+//
+// 4KB 간격으로 페이지마다 라인 하나씩 놓고 랜덤 순환으로 추적한다. 페이지 수를 늘려도
+// 건드리는 라인 수(데이터 양)는 페이지 수 x 64B라서 캐시에 머물고, 늘어나는 것은 TLB
+// 항목 수뿐이다. 같은 라인 수를 촘촘히 모은 packed 추적(huge page 버퍼)을 대조군으로
+// 빼면 남는 차이가 DTLB/STLB 미스와 페이지 워크 비용이다. 같은 접근을 4k, thp,
+// hugetlb 버퍼에서 반복해 huge page로 얼마나 줄어드는지 본다.
+
+#define TLB_STRIDE 4096
+#define TLB_MIN_PAGES 8
+#define TLB_MAX_PAGES (1 << 16)         // 4KB 간격 256MB 범위
+#define TLB_STEPS_PER_OCTAVE 2
+#define TLB_MAX_POINTS 40
+#define TLB_KINDS 3
+
+static const bench_page_kind_t tlb_kinds[TLB_KINDS] = {
+    BENCH_PAGES_4K, BENCH_PAGES_THP, BENCH_PAGES_HUGETLB
+};
+
+typedef struct {
+    size_t pages;                       // 추적하는 페이지(라인) 수
+    bench_stats_t packed;               // 같은 라인 수를 촘촘히 모은 대조군
+    bench_stats_t strided[TLB_KINDS];
+} tlb_point_t;
+
+// 대조군을 뺀 load당 TLB 비용
+static double tlb_extra(const tlb_point_t *point, int kind) {
+    return point->strided[kind].median - point->packed.median;
+}
+
+static void print_tlb_cell(const tlb_point_t *point, int kind, int available) {
+    if (!available) {
+        printf(" %9s %8s", "n/a", "");
+        return;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("shrl $4, %0" : "=r"(c) : "0"(a) : );
+    printf(" %8.2f%s %+8.2f", point->strided[kind].median,
+           point->strided[kind].converged ? " " : "*", tlb_extra(point, kind));
+}
+
+// 대조군 증가로 설명되지 않는 급증 구간 (캐시 경계가 아니라 TLB 경계)
+static void print_tlb_cliffs(const tlb_point_t *points, int count, int kind) {
+    char from[32], to[32];
+    int found = 0;
+
+    for (int i = 1; i < count; i++) {
+        double ratio = points[i].strided[kind].median / points[i - 1].strided[kind].median;
+        double packed_ratio = points[i].packed.median / points[i - 1].packed.median;
+
+        if (ratio <= SWEEP_CLIFF_RATIO * packed_ratio) {
+            continue;
+        }
+        format_size(from, sizeof(from), points[i - 1].pages * TLB_STRIDE);
+        format_size(to, sizeof(to), points[i].pages * TLB_STRIDE);
+        printf("    %zu -> %zu pages (%s -> %s): %.2f -> %.2f cycles\n",
+               points[i - 1].pages, points[i].pages, from, to,
+               points[i - 1].strided[kind].median, points[i].strided[kind].median);
+        found = 1;
+    }
+    if (!found) {
+        printf("    none\n");
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
 }
 
-// ============ 메모리 이동 명령어 테스트 ============
+void run_tlb_suite(void) {
+    static tlb_point_t points[TLB_MAX_POINTS];
+    bench_pages_t buffers[TLB_KINDS], packed;
+    int available[TLB_KINDS];
+    char desc[96], span[32];
+    size_t max_pages = TLB_MAX_PAGES;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    int count = 0;
 
-void test_mov_instruction(test_result_t *result) {
-    strcpy(result->name, "MOV (register)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 0x12345678, b;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("movl %1, %0" : "=r"(b) : "r"(a) : );
+    // --sweep-max로 범위를 줄일 수 있다 (0이면 기본값)
+    while (sweep_max_mb > 0 && max_pages > TLB_MIN_PAGES &&
+           max_pages * TLB_STRIDE > sweep_max_mb * 1024 * 1024) {
+        max_pages /= 2;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("movl %1, %0" : "=r"(b) : "r"(a) : );
+    format_size(span, sizeof(span), max_pages * TLB_STRIDE);
+    printf("TLB / Page Size Sweep: %d..%zu pages, one %d B line per %d B stride (up to %s)\n",
+           TLB_MIN_PAGES, max_pages, SWEEP_LINE_SIZE, TLB_STRIDE, span);
+
+    // 대조군은 TLB 미스가 없도록 가능한 가장 큰 페이지로 할당한다
+    if (!bench_pages_alloc(&packed, max_pages * SWEEP_LINE_SIZE, BENCH_PAGES_HUGETLB)) {
+        printf("Cannot allocate the packed control buffer\n");
+        return;
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+    printf("  %-8s %s\n", "packed", bench_pages_describe(&packed, desc, sizeof(desc)));
+
+    for (int k = 0; k < TLB_KINDS; k++) {
+        available[k] = bench_pages_alloc(&buffers[k], max_pages * TLB_STRIDE, tlb_kinds[k]);
+        if (!available[k]) {
+            printf("  %-8s allocation failed\n", bench_page_names[tlb_kinds[k]]);
+            continue;
+        }
+        // 대체된 종류가 앞 열과 같으면 같은 측정을 반복할 뿐이므로 건너뛴다
+        for (int j = 0; j < k && available[k]; j++) {
+            if (available[j] && buffers[j].kind == buffers[k].kind) {
+                printf("  %-8s not available, falls back to %s (see vm.nr_hugepages / THP setting)\n",
+                       bench_page_names[tlb_kinds[k]], bench_page_names[buffers[k].kind]);
+                bench_pages_free(&buffers[k]);
+                available[k] = 0;
+            }
+        }
+        if (available[k]) {
+            printf("  %-8s %s\n", bench_page_names[tlb_kinds[k]],
+                   bench_pages_describe(&buffers[k], desc, sizeof(desc)));
+        }
+    }
+    fflush(stdout);
+
+    for (int step = 0; count < TLB_MAX_POINTS; step++) {
+        size_t pages = (size_t)(TLB_MIN_PAGES * pow(2.0, (double)step / TLB_STEPS_PER_OCTAVE));
+        tlb_point_t *point = &points[count];
+
+        if (pages > max_pages) {
+            break;
+        }
+        point->pages = pages;
+        measure_chase(packed.base, pages, SWEEP_LINE_SIZE, &rng, &point->packed);
+        for (int k = 0; k < TLB_KINDS; k++) {
+            if (available[k]) {
+                measure_chase(buffers[k].base, pages, TLB_STRIDE, &rng, &point->strided[k]);
+            }
+        }
+        count++;
+    }
+
+    printf("\nCycles per load (+TLB = minus the packed control, * = CI target not reached):\n");
+    printf("%8s %10s %8s", "Pages", "Span", "Packed");
+    for (int k = 0; k < TLB_KINDS; k++) {
+        printf(" %9s %8s", bench_page_names[tlb_kinds[k]], "+TLB");
+    }
+    printf("\n");
+    for (int i = 0; i < count; i++) {
+        format_size(span, sizeof(span), points[i].pages * TLB_STRIDE);
+        printf("%8zu %10s %8.2f", points[i].pages, span, points[i].packed.median);
+        for (int k = 0; k < TLB_KINDS; k++) {
+            print_tlb_cell(&points[i], k, available[k]);
+        }
+        printf("\n");
+    }
+
+    printf("\nTLB cliffs (>%.0f%% increase not explained by the packed control):\n",
+           (SWEEP_CLIFF_RATIO - 1.0) * 100.0);
+    for (int k = 0; k < TLB_KINDS; k++) {
+        if (available[k]) {
+            printf("  %s:\n", bench_page_names[tlb_kinds[k]]);
+            print_tlb_cliffs(points, count, k);
+        }
+    }
+
+    // 가장 넓은 범위에서 4k 대비 huge page가 줄인 load당 비용
+    if (count > 0 && available[0]) {
+        const tlb_point_t *last = &points[count - 1];
+
+        format_size(span, sizeof(span), last->pages * TLB_STRIDE);
+        printf("\nHuge page benefit at %zu pages (%s):\n", last->pages, span);
+        printf("  %-8s %.2f cycles/load, TLB cost %+.2f\n", bench_page_names[tlb_kinds[0]],
+               last->strided[0].median, tlb_extra(last, 0));
+        for (int k = 1; k < TLB_KINDS; k++) {
+            if (!available[k]) {
+                continue;
+            }
+            printf("  %-8s %.2f cycles/load, TLB cost %+.2f, saves %.2f cycles/load (%.0f%%)\n",
+                   bench_page_names[tlb_kinds[k]], last->strided[k].median, tlb_extra(last, k),
+                   last->strided[0].median - last->strided[k].median,
+                   (1.0 - last->strided[k].median / last->strided[0].median) * 100.0);
+        }
+    }
+
+    for (int k = 0; k < TLB_KINDS; k++) {
+        if (available[k]) {
+            bench_pages_free(&buffers[k]);
+        }
+    }
+    bench_pages_free(&packed);
 }
 
-void test_cmp_instruction(test_result_t *result) {
-    strcpy(result->name, "CMP (32-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint32_t a = 100, b = 200;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("cmpl %0, %1" : : "r"(a), "r"(b) : "cc");
+// ============ 메모리 대역폭 (STREAM 방식) ============
+//
+// copy/scale/add/triad 4개 커널을 scalar, AVX2, AVX2 non-temporal store
+// 3가지 변형으로 실행한다. 작업 집합은 sysfs 캐시 크기에서 정한다:
+// 각 레벨 크기의 절반(L3 이상은 스레드 수로 나눔)과, DRAM은 LLC의
+// BW_DRAM_FACTOR배. 스레드마다 자기 배열을 할당(first touch)하고 라운드마다
+// 배리어에서 함께 출발한다. 바이트 수는 STREAM 규칙대로 읽기+쓰기 배열만 센다
+// (write-allocate 트래픽 제외).
+
+#define BW_ROUNDS 5                     // 라운드 수 (집계 대역폭의 중앙값 사용)
+#define BW_ROUND_BYTES (128UL << 20)    // 라운드당 스레드별 최소 전송량
+#define BW_DRAM_FACTOR 4                // DRAM 작업 집합 = LLC x BW_DRAM_FACTOR
+#define BW_DRAM_MAX_BYTES (1024UL << 20)
+#define BW_MIN_ELEMENTS 64
+#define BW_SCALAR __attribute__((optimize("no-tree-vectorize")))    // 자동 벡터화 방지
+
+typedef enum {
+    STREAM_COPY = 0,
+    STREAM_SCALE,
+    STREAM_ADD,
+    STREAM_TRIAD,
+    STREAM_KERNEL_COUNT
+} stream_kernel_t;
+
+typedef enum {
+    STREAM_SCALAR = 0,
+    STREAM_AVX2,
+    STREAM_NT,
+    STREAM_VARIANT_COUNT
+} stream_variant_t;
+
+#define STREAM_COMBOS (STREAM_KERNEL_COUNT * STREAM_VARIANT_COUNT)
+
+static const char *const stream_kernel_names[STREAM_KERNEL_COUNT] = { "Copy", "Scale", "Add", "Triad" };
+static const char *const stream_variant_names[STREAM_VARIANT_COUNT] = { "scalar", "avx2", "avx2-nt" };
+static const int stream_arrays[STREAM_KERNEL_COUNT] = { 2, 2, 3, 3 };  // 원소당 접근 배열 수
+static const unsigned stream_variant_isa[STREAM_VARIANT_COUNT] = { 0, BENCH_ISA_AVX, BENCH_ISA_AVX };
+
+#define STREAM_SCALAR_K 3.0
+
+typedef void (*stream_fn)(double *a, double *b, double *c, size_t n);
+
+// c = a / b = k*c / c = a + b / a = b + k*c
+static BW_SCALAR void stream_copy_scalar(double *a, double *b, double *c, size_t n) {
+    (void)b;
+    for (size_t i = 0; i < n; i++) c[i] = a[i];
+}
+static BW_SCALAR void stream_scale_scalar(double *a, double *b, double *c, size_t n) {
+    (void)a;
+    for (size_t i = 0; i < n; i++) b[i] = STREAM_SCALAR_K * c[i];
+}
+static BW_SCALAR void stream_add_scalar(double *a, double *b, double *c, size_t n) {
+    for (size_t i = 0; i < n; i++) c[i] = a[i] + b[i];
+}
+static BW_SCALAR void stream_triad_scalar(double *a, double *b, double *c, size_t n) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i] + STREAM_SCALAR_K * c[i];
+}
+
+// AVX2 변형: STORE는 _mm256_store_pd(일반) 또는 _mm256_stream_pd(non-temporal).
+// 256-bit 부동소수 연산만 쓰므로 AVX면 충분하다 (없으면 변형 전체를 건너뜀).
+#define DEFINE_STREAM_AVX2(suffix, STORE) \
+static TARGET_AVX void stream_copy_##suffix(double *a, double *b, double *c, size_t n) { \
+    (void)b; \
+    for (size_t i = 0; i < n; i += 4) STORE(c + i, _mm256_load_pd(a + i)); \
+} \
+static TARGET_AVX void stream_scale_##suffix(double *a, double *b, double *c, size_t n) { \
+    __m256d k = _mm256_set1_pd(STREAM_SCALAR_K); \
+    (void)a; \
+    for (size_t i = 0; i < n; i += 4) STORE(b + i, _mm256_mul_pd(k, _mm256_load_pd(c + i))); \
+} \
+static TARGET_AVX void stream_add_##suffix(double *a, double *b, double *c, size_t n) { \
+    for (size_t i = 0; i < n; i += 4) \
+        STORE(c + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i))); \
+} \
+static TARGET_AVX void stream_triad_##suffix(double *a, double *b, double *c, size_t n) { \
+    __m256d k = _mm256_set1_pd(STREAM_SCALAR_K); \
+    for (size_t i = 0; i < n; i += 4) \
+        STORE(a + i, _mm256_add_pd(_mm256_load_pd(b + i), _mm256_mul_pd(k, _mm256_load_pd(c + i)))); \
+}
+
+#define NT_STORE(p, v) _mm256_stream_pd(p, v)
+
+DEFINE_STREAM_AVX2(avx2, _mm256_store_pd)
+DEFINE_STREAM_AVX2(nt, NT_STORE)
+
+static const stream_fn stream_kernels[STREAM_KERNEL_COUNT][STREAM_VARIANT_COUNT] = {
+    { stream_copy_scalar,  stream_copy_avx2,  stream_copy_nt },
+    { stream_scale_scalar, stream_scale_avx2, stream_scale_nt },
+    { stream_add_scalar,   stream_add_avx2,   stream_add_nt },
+    { stream_triad_scalar, stream_triad_avx2, stream_triad_nt },
+};
+
+typedef struct {
+    size_t elements;            // 스레드별 배열당 원소 수 (8의 배수)
+    double checksum;            // 결과가 최적화로 사라지지 않도록 누적
+    pthread_mutex_t lock;
+    double elapsed_ns[STREAM_COMBOS][BENCH_MAX_CPUS][BW_ROUNDS];
+    uint64_t bytes[STREAM_COMBOS];  // 라운드당 스레드별 전송 바이트
+} bandwidth_run_t;
+
+static void bandwidth_worker(bench_team_t *team, int index, void *arg) {
+    bandwidth_run_t *run = arg;
+    size_t n = run->elements;
+    double *a = aligned_alloc(64, n * sizeof(double));
+    double *b = aligned_alloc(64, n * sizeof(double));
+    double *c = aligned_alloc(64, n * sizeof(double));
+    double checksum;
+
+    for (size_t i = 0; i < n; i++) {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("cmpl %0, %1" : : "r"(a), "r"(b) : "cc");
+
+    for (int k = 0; k < STREAM_KERNEL_COUNT; k++) {
+        for (int v = 0; v < STREAM_VARIANT_COUNT; v++) {
+            int combo = k * STREAM_VARIANT_COUNT + v;
+            uint64_t pass_bytes = (uint64_t)stream_arrays[k] * n * sizeof(double);
+            uint64_t reps = BW_ROUND_BYTES / pass_bytes > 0 ? BW_ROUND_BYTES / pass_bytes : 1;
+            stream_fn fn = stream_kernels[k][v];
+
+            if (!bench_cpu_has(&cpu, stream_variant_isa[v])) {
+                continue;
+            }
+            if (index == 0) {
+                run->bytes[combo] = reps * pass_bytes;
+            }
+            fn(a, b, c, n);
+            _mm_sfence();
+
+            for (int r = 0; r < BW_ROUNDS; r++) {
+                struct timespec start_time, end_time;
+
+                bench_team_sync(team);
+                clock_gettime(CLOCK_MONOTONIC, &start_time);
+                for (uint64_t rep = 0; rep < reps; rep++) {
+                    fn(a, b, c, n);
+                }
+                _mm_sfence();   // non-temporal store 완료까지 포함
+                clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+                run->elapsed_ns[combo][index][r] = (end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                                                   (end_time.tv_nsec - start_time.tv_nsec);
+            }
+        }
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+
+    checksum = a[0] + b[n / 2] + c[n - 1];
+    pthread_mutex_lock(&run->lock);
+    run->checksum += checksum;
+    pthread_mutex_unlock(&run->lock);
+
+    free(a);
+    free(b);
+    free(c);
 }
 
-// ============ SSE/SSE2 명령어 테스트 ============
+// 한 레벨/스레드 수의 집계 GB/s (= bytes/ns) 를 combo별로 gbps에 기록
+static void measure_bandwidth(const bench_topology_t *topo, int threads, size_t elements,
+                              bandwidth_run_t *run, double *gbps) {
+    int pinned;
 
-void test_sse_add_instruction(test_result_t *result) {
-    strcpy(result->name, "SSE2 PADDQ");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    uint64_t test_data[4] = {0x1111111111111111ULL, 0x2222222222222222ULL,
-                             0x3333333333333333ULL, 0x4444444444444444ULL};
-    volatile uint64_t dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "movq %1, %%xmm0\n\t"
-            "movq %2, %%xmm1\n\t"
-            "movq %3, %%xmm2\n\t" 
-            "movq %4, %%xmm3\n\t"
-            "punpcklqdq %%xmm1, %%xmm0\n\t"
-            "punpcklqdq %%xmm3, %%xmm2\n\t"
-            "paddq %%xmm2, %%xmm0\n\t"
-            "movq %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[1]), "m"(test_data[2]), "m"(test_data[3])
-            : "xmm0", "xmm1", "xmm2", "xmm3", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "movq %1, %%xmm0\n\t"
-            "movq %2, %%xmm1\n\t"
-            "movq %3, %%xmm2\n\t"
-            "movq %4, %%xmm3\n\t"
-            "punpcklqdq %%xmm1, %%xmm0\n\t"
-            "punpcklqdq %%xmm3, %%xmm2\n\t"
-            "paddq %%xmm2, %%xmm0\n\t"
-            "movq %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[1]), "m"(test_data[2]), "m"(test_data[3])
-            : "xmm0", "xmm1", "xmm2", "xmm3", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 0x123456789ABCDEF0ULL) printf("");
+    run->elements = elements;
+    pinned = bench_team_run(threads, topo->cpus, bandwidth_worker, run) == 0;
+
+    for (int combo = 0; combo < STREAM_COMBOS; combo++) {
+        double aggregate[BW_ROUNDS];
+
+        if (!pinned) {
+            gbps[combo] = -1.0;     // 스레드를 고정하지 못해 측정하지 않음
+            continue;
+        }
+        if (!bench_cpu_has(&cpu, stream_variant_isa[combo % STREAM_VARIANT_COUNT])) {
+            gbps[combo] = -1.0;     // 이 CPU에서 실행할 수 없는 변형
+            continue;
+        }
+        for (int r = 0; r < BW_ROUNDS; r++) {
+            double wall = 0.0;
+
+            for (int t = 0; t < threads; t++) {
+                if (run->elapsed_ns[combo][t][r] > wall) {
+                    wall = run->elapsed_ns[combo][t][r];
+                }
+            }
+            aggregate[r] = (double)threads * run->bytes[combo] / wall;
+        }
+        gbps[combo] = median_of(aggregate, BW_ROUNDS);
+    }
 }
 
-void test_sse_float_add_instruction(test_result_t *result) {
-    strcpy(result->name, "SSE ADDPS");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    float test_data[8] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f};
-    volatile float dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "movups %1, %%xmm0\n\t"
-            "movups %2, %%xmm1\n\t"
-            "addps %%xmm1, %%xmm0\n\t"
-            "movss %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[4])
-            : "xmm0", "xmm1", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "movups %1, %%xmm0\n\t"
-            "movups %2, %%xmm1\n\t"
-            "addps %%xmm1, %%xmm0\n\t"
-            "movss %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[4])
-            : "xmm0", "xmm1", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 123.456f) printf("");
+// 스레드별 작업 집합 (3개 배열 합계). level_count번째는 DRAM.
+static size_t bandwidth_working_set(const cache_level_t *levels, int level_count, int level,
+                                    int threads) {
+    if (level == level_count) {
+        size_t dram = level_count > 0 ? levels[level_count - 1].size * BW_DRAM_FACTOR
+                                      : BW_DRAM_MAX_BYTES;
+        return (dram < BW_DRAM_MAX_BYTES ? dram : BW_DRAM_MAX_BYTES) / threads;
+    }
+    // L1/L2는 코어 전용, L3 이상은 스레드끼리 나눠 쓴다고 본다
+    return levels[level].size / 2 / (levels[level].level >= 3 ? threads : 1);
 }
 
-void test_sse_float_mul_instruction(test_result_t *result) {
-    strcpy(result->name, "SSE MULPS");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    float test_data[8] = {1.1f, 2.2f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f};
-    volatile float dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "movups %1, %%xmm0\n\t"
-            "movups %2, %%xmm1\n\t"
-            "mulps %%xmm1, %%xmm0\n\t"
-            "movss %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[4])
-            : "xmm0", "xmm1", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "movups %1, %%xmm0\n\t"
-            "movups %2, %%xmm1\n\t"
-            "mulps %%xmm1, %%xmm0\n\t"
-            "movss %%xmm0, %0\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data[0]), "m"(test_data[4])
-            : "xmm0", "xmm1", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 123.456f) printf("");
+void run_bandwidth_suite(void) {
+    bench_topology_t topo;
+    cache_level_t levels[MAX_CACHE_LEVELS];
+    int level_count = read_cache_levels(levels);
+    int threads_limit;
+    bandwidth_run_t *run = calloc(1, sizeof(*run));
+    static double gbps[MAX_CACHE_LEVELS + 1][BENCH_MAX_CPUS + 1][STREAM_COMBOS];
+
+    bench_topology_detect(&topo);
+    threads_limit = max_threads > 0 && max_threads < topo.count ? max_threads : topo.count;
+    pthread_mutex_init(&run->lock, NULL);
+
+    printf("Memory Bandwidth Test (STREAM copy/scale/add/triad)\n");
+    printf("===================================================\n\n");
+    bench_topology_describe(&topo);
+    printf("Threads: 1..%d, %d rounds of >= %lu MB per thread (median round reported)\n",
+           threads_limit, BW_ROUNDS, BW_ROUND_BYTES >> 20);
+
+    for (int level = 0; level <= level_count; level++) {
+        char size_label[32], name[48];
+
+        if (level < level_count) {
+            format_size(size_label, sizeof(size_label), levels[level].size);
+            snprintf(name, sizeof(name), "L%d (%s)", levels[level].level, size_label);
+        } else {
+            snprintf(name, sizeof(name), "DRAM");
+        }
+        printf("\n%s: working set per thread", name);
+
+        for (int threads = 1; threads <= threads_limit; threads++) {
+            size_t bytes = bandwidth_working_set(levels, level_count, level, threads);
+            size_t elements = bytes / 3 / sizeof(double) & ~(size_t)7;
+
+            if (elements < BW_MIN_ELEMENTS) {
+                elements = BW_MIN_ELEMENTS;
+            }
+            if (threads == 1 || threads == threads_limit) {
+                format_size(size_label, sizeof(size_label), elements * 3 * sizeof(double));
+                printf(" %s%s", threads == 1 ? "" : "-> ", size_label);
+            }
+            measure_bandwidth(&topo, threads, elements, run, gbps[level][threads]);
+        }
+
+        printf("\n%-8s %-8s", "Kernel", "Variant");
+        for (int threads = 1; threads <= threads_limit; threads++) {
+            char column[16];
+            snprintf(column, sizeof(column), "%dT%s", threads, topo.smt_sibling[threads - 1] ? "*" : "");
+            printf(" %9s", column);
+        }
+        printf("\n");
+        for (int combo = 0; combo < STREAM_COMBOS; combo++) {
+            printf("%-8s %-8s", stream_kernel_names[combo / STREAM_VARIANT_COUNT],
+                   stream_variant_names[combo % STREAM_VARIANT_COUNT]);
+            for (int threads = 1; threads <= threads_limit; threads++) {
+                if (gbps[level][threads][combo] < 0.0) {
+                    printf(" %9s", "n/a");
+                } else {
+                    printf(" %9.2f", gbps[level][threads][combo]);
+                }
+            }
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+
+    printf("\nNotes:\n");
+    printf("- Values are aggregate GB/s (10^9 bytes/s) over all threads; per-thread = value / threads\n");
+    printf("- Bytes count each array read or written once per element (copy/scale 16 B, add/triad 24 B);\n"
+           "  write-allocate traffic of regular stores is not counted, so avx2-nt can exceed avx2\n");
+    printf("- nT* marks a thread count that includes an SMT sibling\n");
+    printf("- n/a: the variant needs an ISA this CPU does not support (avx2 variants need AVX),\n"
+           "  or the threads could not be pinned (see stderr)\n");
+    printf("- Checksum: %.1f\n", run->checksum);
+
+    pthread_mutex_destroy(&run->lock);
+    free(run);
 }
 
-// ============ AVX/AVX2 명령어 테스트 ============
+// ============ 분기 예측 (방향 패턴 / 간접 분기 / BTB 용량) ============
+//
+// 방향 패턴: 패턴 배열의 바이트를 하나씩 읽어 threshold보다 작으면 taken인 조건
+// 분기(jb)를 실행한다. 코드는 그대로 두고 패턴만 바꾸므로 always-taken과의 사이클
+// 차이가 예측 실패 비용이다. 오예측 페널티 = Δcycles/분기 ÷ Δ오예측/분기이며,
+// 분기 미스 카운터가 없으면 i.i.d. 랜덤 패턴의 기대 오예측률(min(p, 1-p))을 쓴다.
+// 간접 분기: 16개 대상의 점프 테이블(jmp *%rax)을 인덱스 배열로 구동한다.
+// BTB 용량: .rept로 서로 다른 taken jmp N개를 BTB_SITE_SPACING바이트 간격으로
+// 늘어놓고 N을 키운다. BTB를 넘으면 분기마다 프런트엔드가 다시 조정되어
+// 분기당 사이클이 뛴다 (코드 크기가 L1i를 넘는 지점과 구분하도록 크기도 출력).
 
-void test_avx_add_instruction(test_result_t *result) {
-    strcpy(result->name, "AVX2 VPADDQ");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    uint64_t test_data_a[4] = {0x1111111111111111ULL, 0x2222222222222222ULL,
-                               0x3333333333333333ULL, 0x4444444444444444ULL};
-    uint64_t test_data_b[4] = {0x5555555555555555ULL, 0x6666666666666666ULL,
-                               0x7777777777777777ULL, 0x8888888888888888ULL};
-    volatile uint64_t dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovdqu %1, %%ymm0\n\t"
-            "vmovdqu %2, %%ymm1\n\t"
-            "vpaddq %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovq %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovdqu %1, %%ymm0\n\t"
-            "vmovdqu %2, %%ymm1\n\t"
-            "vpaddq %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovq %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 0x123456789ABCDEF0ULL) printf("");
+#define BRANCH_PATTERN_LEN (1 << 16)    // 패턴 배열 길이 (샘플 1개 = 한 바퀴)
+#define BRANCH_MAX_PERIOD 4096          // 주기 패턴 최대 주기
+#define BRANCH_RANDOM_SEED 0x2545F4914F6CDD1DULL
+#define JUMP_TABLE_TARGETS 16
+#define BTB_SITE_SPACING 8              // 분기 사이트 간격 (bytes)
+#define BTB_STR(x) #x
+#define BTB_XSTR(x) BTB_STR(x)
+#define BTB_BRANCHES_PER_SAMPLE (1 << 18)
+
+typedef void (*branch_pass_fn)(const uint8_t *data, unsigned arg, uint32_t *acc);
+
+// 조건 분기 1개: 바이트 < threshold 이면 taken (건너뛴 incl은 not-taken 횟수)
+#define BRANCH_DIR_OP(d) \
+    "movzbl (%[p]), %%eax\n\tincq %[p]\n\tcmpl %[threshold], %%eax\n\tjb 1f\n\tincl %[acc]\n\t1:\n\t"
+
+static void branch_direction_pass(const uint8_t *data, unsigned threshold, uint32_t *acc) {
+    const uint8_t *p = data;
+    uint32_t a = *acc;
+
+    for (size_t i = 0; i < BRANCH_PATTERN_LEN; i += 8) {
+        __asm__ volatile (REP8(BRANCH_DIR_OP(""))
+                          : [p] "+r"(p), [acc] "+r"(a) : [threshold] "r"(threshold)
+                          : "eax", "cc", "memory");
+    }
+    *acc = a;
 }
 
-void test_avx_float_add_instruction(test_result_t *result) {
-    strcpy(result->name, "AVX VADDPS");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    float test_data_a[8] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f};
-    float test_data_b[8] = {8.0f, 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f};
-    volatile float dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovups %1, %%ymm0\n\t"
-            "vmovups %2, %%ymm1\n\t"
-            "vaddps %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovss %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovups %1, %%ymm0\n\t"
-            "vmovups %2, %%ymm1\n\t"
-            "vaddps %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovss %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 123.456f) printf("");
+// 간접 분기 1개: 인덱스 바이트로 .rodata의 상대 오프셋 테이블을 읽어 jmp *%rax.
+// 대상마다 누산기에 다른 값을 더하고 공통 출구(99)로 직접 jmp 한다.
+#define JT_CASE(label, inc) #label ": addl $" #inc ", %[acc]\n\tjmp 99f\n"
+#define JT_OP(d) \
+    ".pushsection .rodata\n\t.balign 4\n" \
+    "91:\n\t.long 10f-91b, 11f-91b, 12f-91b, 13f-91b, 14f-91b, 15f-91b, 16f-91b, 17f-91b\n\t" \
+    ".long 18f-91b, 19f-91b, 20f-91b, 21f-91b, 22f-91b, 23f-91b, 24f-91b, 25f-91b\n\t" \
+    ".popsection\n\t" \
+    "movzbl (%[p]), %%eax\n\tincq %[p]\n\t" \
+    "leaq 91b(%%rip), %%rdx\n\tmovslq (%%rdx,%%rax,4), %%rax\n\taddq %%rdx, %%rax\n\tjmp *%%rax\n" \
+    JT_CASE(10, 1) JT_CASE(11, 2) JT_CASE(12, 3) JT_CASE(13, 4) \
+    JT_CASE(14, 5) JT_CASE(15, 6) JT_CASE(16, 7) JT_CASE(17, 8) \
+    JT_CASE(18, 9) JT_CASE(19, 10) JT_CASE(20, 11) JT_CASE(21, 12) \
+    JT_CASE(22, 13) JT_CASE(23, 14) JT_CASE(24, 15) JT_CASE(25, 16) \
+    "99:\n\t"
+
+static void branch_indirect_pass(const uint8_t *data, unsigned arg, uint32_t *acc) {
+    const uint8_t *p = data;
+    uint32_t a = *acc;
+
+    (void)arg;
+    for (size_t i = 0; i < BRANCH_PATTERN_LEN; i += 8) {
+        __asm__ volatile (REP8(JT_OP(""))
+                          : [p] "+r"(p), [acc] "+r"(a) : : "rax", "rdx", "cc", "memory");
+    }
+    *acc = a;
+}
+
+// sites개의 서로 다른 taken jmp를 repeats번 실행
+#define DEFINE_BTB_PASS(sites) \
+static void btb_pass_##sites(const uint8_t *data, unsigned repeats, uint32_t *acc) { \
+    (void)data; \
+    (void)acc; \
+    for (unsigned r = 0; r < repeats; r++) { \
+        __asm__ volatile (".rept " #sites "\n\tjmp 1f\n\t.balign " BTB_XSTR(BTB_SITE_SPACING) "\n1:\n\t.endr\n\t" \
+                          : : : "memory"); \
+    } \
 }
 
-void test_avx_float_mul_instruction(test_result_t *result) {
-    strcpy(result->name, "AVX VMULPS");
-    
+DEFINE_BTB_PASS(16)    DEFINE_BTB_PASS(24)    DEFINE_BTB_PASS(32)    DEFINE_BTB_PASS(48)
+DEFINE_BTB_PASS(64)    DEFINE_BTB_PASS(96)    DEFINE_BTB_PASS(128)   DEFINE_BTB_PASS(192)
+DEFINE_BTB_PASS(256)   DEFINE_BTB_PASS(384)   DEFINE_BTB_PASS(512)   DEFINE_BTB_PASS(768)
+DEFINE_BTB_PASS(1024)  DEFINE_BTB_PASS(1536)  DEFINE_BTB_PASS(2048)  DEFINE_BTB_PASS(3072)
+DEFINE_BTB_PASS(4096)  DEFINE_BTB_PASS(6144)  DEFINE_BTB_PASS(8192)  DEFINE_BTB_PASS(12288)
+DEFINE_BTB_PASS(16384)
+
+#define BTB_POINT(sites) { sites, btb_pass_##sites }
+
+static const struct {
+    unsigned sites;
+    branch_pass_fn pass;
+} btb_points[] = {
+    BTB_POINT(16),    BTB_POINT(24),    BTB_POINT(32),    BTB_POINT(48),
+    BTB_POINT(64),    BTB_POINT(96),    BTB_POINT(128),   BTB_POINT(192),
+    BTB_POINT(256),   BTB_POINT(384),   BTB_POINT(512),   BTB_POINT(768),
+    BTB_POINT(1024),  BTB_POINT(1536),  BTB_POINT(2048),  BTB_POINT(3072),
+    BTB_POINT(4096),  BTB_POINT(6144),  BTB_POINT(8192),  BTB_POINT(12288),
+    BTB_POINT(16384),
+};
+
+#define BTB_POINT_COUNT ((int)(sizeof(btb_points) / sizeof(btb_points[0])))
+
+typedef struct {
+    branch_pass_fn pass;
+    const uint8_t *data;
+    unsigned arg;
+    uint64_t ops;               // 샘플당 측정 분기 수
+    const bench_perf_t *perf;
+    uint32_t acc;               // 결과가 최적화로 사라지지 않도록 누적
+    double total_ns;
+    uint64_t total_ops;
+} branch_sampler_t;
+
+typedef struct {
+    double cycles;              // 분기당 cycles (샘플 중앙값)
+    double ns;
+    double misses;              // 분기당 오예측 (카운터가 없으면 음수)
+    bench_stats_t stats;
+} branch_result_t;
+
+static double sample_branch(void *arg) {
+    branch_sampler_t *sampler = arg;
     uint64_t start_cycles, end_cycles;
     struct timespec start_time, end_time;
-    
-    float test_data_a[8] = {1.1f, 2.2f, 3.3f, 4.4f, 5.5f, 6.6f, 7.7f, 8.8f};
-    float test_data_b[8] = {2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f};
-    volatile float dummy_result = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovups %1, %%ymm0\n\t"
-            "vmovups %2, %%ymm1\n\t"
-            "vmulps %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovss %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
+
     clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "vmovups %1, %%ymm0\n\t"
-            "vmovups %2, %%ymm1\n\t"
-            "vmulps %%ymm1, %%ymm0, %%ymm0\n\t"
-            "vmovss %%xmm0, %0\n\t"
-            "vzeroupper\n\t"
-            : "=m"(dummy_result)
-            : "m"(test_data_a[0]), "m"(test_data_b[0])
-            : "ymm0", "ymm1", "memory"
-        );
-    }
-    
-    end_cycles = rdtsc();
+    bench_perf_start(sampler->perf);
+    start_cycles = bench_timer_start(&timer);
+
+    sampler->pass(sampler->data, sampler->arg, &sampler->acc);
+
+    end_cycles = bench_timer_stop(&timer);
+    bench_perf_stop(sampler->perf);
     clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    if (dummy_result == 123.456f) printf("");
+
+    sampler->total_ns += (end_time.tv_sec - start_time.tv_sec) * 1e9 +
+                         (end_time.tv_nsec - start_time.tv_nsec);
+    sampler->total_ops += sampler->ops;
+    return (double)(end_cycles - start_cycles) / sampler->ops;
 }
 
-// ============ 비트 조작 명령어 테스트 ============
+// 예측기를 학습시킨 뒤 샘플링. 카운터 그룹은 측정마다 새로 연다.
+static void measure_branch(branch_sampler_t *sampler, uint32_t *checksum, branch_result_t *result) {
+    bench_perf_t perf;
+    bench_perf_counts_t counts;
 
-void test_popcnt_instruction(test_result_t *result) {
-    strcpy(result->name, "POPCNT (64-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint64_t a = 0x123456789ABCDEFULL, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("popcntq %1, %0" : "=r"(c) : "r"(a) : );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("popcntq %1, %0" : "=r"(c) : "r"(a) : );
+    bench_perf_open(&perf);
+    sampler->perf = &perf;
+    for (int i = 0; i < 2; i++) {
+        sampler->pass(sampler->data, sampler->arg, &sampler->acc);
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+
+    bench_perf_reset(&perf);
+    bench_sample(&sampling, sample_branch, sampler, &result->stats);
+    bench_perf_read(&perf, &counts);
+    bench_perf_close(&perf);
+
+    result->cycles = result->stats.median;
+    result->ns = sampler->total_ns / sampler->total_ops;
+    result->misses = bench_perf_per_op(&counts, BENCH_PERF_BRANCH_MISSES, sampler->total_ops);
+    *checksum += sampler->acc;
 }
 
-void test_lzcnt_instruction(test_result_t *result) {
-    strcpy(result->name, "LZCNT (64-bit)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile uint64_t a = 0x0000123456789ABCULL, c;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile ("lzcntq %1, %0" : "=r"(c) : "r"(a) : );
+// 완벽히 예측될 때의 기준 비용. 방향 패턴은 taken 분기가 not-taken보다 비쌀 수
+// 있으므로 always/never taken 두 행을 taken 비율로 보간한다.
+typedef struct {
+    double cycles;
+    double misses;              // 카운터가 없으면 음수
+} branch_baseline_t;
+
+static branch_baseline_t branch_mix_baseline(const branch_result_t *taken,
+                                             const branch_result_t *not_taken, double taken_ratio) {
+    branch_baseline_t base = {
+        .cycles = taken_ratio * taken->cycles + (1.0 - taken_ratio) * not_taken->cycles,
+        .misses = -1.0,
+    };
+
+    if (taken->misses >= 0.0 && not_taken->misses >= 0.0) {
+        base.misses = taken_ratio * taken->misses + (1.0 - taken_ratio) * not_taken->misses;
     }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile ("lzcntq %1, %0" : "=r"(c) : "r"(a) : );
+    return base;
+}
+
+// 기준 대비 오예측 1회당 추가 사이클. 카운터 값이 있으면 실측 오예측률,
+// 없으면 expected_miss(음수면 모름)를 쓴다. 추정할 수 없으면 음수.
+static double branch_penalty(const branch_result_t *r, branch_baseline_t base,
+                             double expected_miss) {
+    double extra_cycles = r->cycles - base.cycles;
+
+    if (r->misses >= 0.0 && base.misses >= 0.0) {
+        double extra_misses = r->misses - base.misses;
+        return extra_misses > 0.01 ? extra_cycles / extra_misses : -1.0;
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+    return expected_miss > 0.0 ? extra_cycles / expected_miss : -1.0;
 }
 
-// ============ 메모리 접근 명령어 테스트 ============
+// value는 두 번째 컬럼 (taken 비율 또는 대상 수)
+static void print_branch_row(const char *label, double value, int precision,
+                             const branch_result_t *r, double penalty) {
+    printf("%-24s", label);
+    bench_perf_print_value(value, 8, precision);
+    printf(" %10.3f %8.3f", r->cycles, r->ns);
+    bench_perf_print_value(r->misses, 9, 4);
+    bench_perf_print_value(penalty, 9, 1);
+    printf(" %6.2f%s\n", r->stats.ci_percent, r->stats.converged ? "" : "*");
+    fflush(stdout);
+}
 
-void test_memory_load(test_result_t *result) {
-    strcpy(result->name, "Memory LOAD (L1)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    // 32KB 배열 (L1 캐시 크기)
-    volatile uint32_t *array = malloc(32 * 1024);
-    for (int i = 0; i < 8 * 1024; i++) {
-        array[i] = i;
-    }
-    
-    volatile uint32_t sum = 0;
-    int iterations = ITERATIONS / 1000;
-    
-    for (int i = 0; i < iterations / 10; i++) {
-        sum += array[i % (8 * 1024)];
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < iterations; i++) {
-        sum += array[i % (8 * 1024)];
+static void print_branch_header(const char *label, const char *taken) {
+    printf("%-24s %8s %10s %8s %9s %9s %7s\n", label, taken, "Cycles/br", "ns/br",
+           "BrMis/br", "Penalty", "CI(%)");
+}
+
+// 방향 패턴 하나를 측정해 출력한다. base[0]/base[1]은 always/never taken 결과이며,
+// 아직 측정되지 않았으면(샘플 0개) 이 행이 그 기준이 된다.
+static void run_direction_pattern(const char *label, uint8_t *pattern, unsigned threshold,
+                                  double expected_miss, branch_result_t *base, uint32_t *checksum,
+                                  branch_result_t *result) {
+    branch_sampler_t sampler = {
+        .pass = branch_direction_pass, .data = pattern, .arg = threshold,
+        .ops = BRANCH_PATTERN_LEN,
+    };
+    size_t taken = 0;
+    double ratio;
+    int is_base = base[0].stats.samples == 0 || base[1].stats.samples == 0;
+
+    for (size_t i = 0; i < BRANCH_PATTERN_LEN; i++) {
+        taken += pattern[i] < threshold;
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / iterations;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / iterations;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    free((void*)array);
+    ratio = (double)taken / BRANCH_PATTERN_LEN;
+    measure_branch(&sampler, checksum, result);
+    if (is_base) {
+        base[base[0].stats.samples == 0 ? 0 : 1] = *result;
+    }
+    print_branch_row(label, 100.0 * ratio, 1, result, is_base ? -1.0 :
+                     branch_penalty(result, branch_mix_baseline(&base[0], &base[1], ratio),
+                                    expected_miss));
 }
 
-void test_memory_load_l2(test_result_t *result) {
-    strcpy(result->name, "Memory LOAD (L2)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    // 256KB 배열 (L2 캐시 크기)
-    volatile uint32_t *array = malloc(256 * 1024);
-    for (int i = 0; i < 64 * 1024; i++) {
-        array[i] = i;
-    }
-    
-    volatile uint32_t sum = 0;
-    int iterations = ITERATIONS / 1000;
-    
-    for (int i = 0; i < iterations / 10; i++) {
-        sum += array[i % (64 * 1024)];
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < iterations; i++) {
-        sum += array[i % (64 * 1024)];
+static int compare_byte(const void *a, const void *b) {
+    return *(const uint8_t *)a - *(const uint8_t *)b;
+}
+
+void run_branch_suite(void) {
+    uint8_t *pattern = malloc(BRANCH_PATTERN_LEN);
+    uint64_t rng = BRANCH_RANDOM_SEED;
+    uint32_t checksum = 0;
+    branch_result_t base[2] = {{0}}, result;
+    char label[48];
+    double penalty = -1.0;
+    static const int random_rates[] = { 1, 10, 25, 50, 75, 90, 99 };   // taken 비율 (%)
+
+    printf("Branch Prediction Suite\n");
+    printf("=======================\n\n");
+    printf("Pattern length: %d branches per sample (one pass), predictor warmed for 2 passes\n",
+           BRANCH_PATTERN_LEN);
+
+    // --- 방향 패턴: 모두 같은 jb 코드, 패턴 바이트만 다르다 (0 = taken, 1 = not taken) ---
+    printf("\nConditional branch patterns (jb per element):\n");
+    print_branch_header("Pattern", "Taken(%)");
+
+    memset(pattern, 0, BRANCH_PATTERN_LEN);
+    run_direction_pattern("always taken", pattern, 1, 0.0, base, &checksum, &result);
+    memset(pattern, 1, BRANCH_PATTERN_LEN);
+    run_direction_pattern("never taken", pattern, 1, 0.0, base, &checksum, &result);
+
+    // 길이 k의 랜덤 taken/not-taken 열을 반복: 예측기 히스토리가 k를 담지 못하면 미스
+    for (int period = 2; period <= BRANCH_MAX_PERIOD; period *= 2) {
+        for (int i = 0; i < period; i++) {
+            pattern[i] = xorshift64(&rng) & 1;
+        }
+        for (size_t i = period; i < BRANCH_PATTERN_LEN; i++) {
+            pattern[i] = pattern[i % period];
+        }
+        snprintf(label, sizeof(label), "periodic k=%d", period);
+        run_direction_pattern(label, pattern, 1, -1.0, base, &checksum, &result);
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / iterations;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / iterations;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    free((void*)array);
+
+    for (size_t r = 0; r < sizeof(random_rates) / sizeof(random_rates[0]); r++) {
+        double p = random_rates[r] / 100.0;
+
+        for (size_t i = 0; i < BRANCH_PATTERN_LEN; i++) {
+            pattern[i] = (xorshift64(&rng) % 10000) >= (uint64_t)(p * 10000);
+        }
+        snprintf(label, sizeof(label), "random %d%% taken", random_rates[r]);
+        run_direction_pattern(label, pattern, 1, p < 0.5 ? p : 1.0 - p, base, &checksum, &result);
+        if (random_rates[r] == 50) {
+            // 요약 페널티: 카운터가 없어도 기대 오예측률(50%)이 확실한 행
+            penalty = branch_penalty(&result, branch_mix_baseline(&base[0], &base[1], 0.5), 0.5);
+        }
+    }
+
+    // 데이터 의존: 랜덤 바이트 < 128 분기를 정렬 전/후 같은 데이터로
+    for (size_t i = 0; i < BRANCH_PATTERN_LEN; i++) {
+        pattern[i] = xorshift64(&rng) & 0xFF;
+    }
+    run_direction_pattern("data < 128 (unsorted)", pattern, 128, 0.5, base, &checksum, &result);
+    qsort(pattern, BRANCH_PATTERN_LEN, 1, compare_byte);
+    run_direction_pattern("data < 128 (sorted)", pattern, 128, 0.0, base, &checksum, &result);
+
+
+    // --- 간접 분기: 같은 점프 테이블, 인덱스 열만 다르다 ---
+    printf("\nIndirect branch / jump table (%d targets, jmp *%%rax per element):\n",
+           JUMP_TABLE_TARGETS);
+    print_branch_header("Target pattern", "Targets");
+    {
+        branch_result_t jt_base = {0};
+        branch_sampler_t sampler = {
+            .pass = branch_indirect_pass, .data = pattern, .ops = BRANCH_PATTERN_LEN,
+        };
+
+        for (int kind = 0; kind < 2; kind++) {
+            for (int targets = 1; targets <= JUMP_TABLE_TARGETS; targets *= 2) {
+                if (targets == 1 && kind == 1) {
+                    continue;   // 대상 1개는 순환/랜덤이 같다
+                }
+                for (size_t i = 0; i < BRANCH_PATTERN_LEN; i++) {
+                    pattern[i] = kind == 0 ? i % targets : xorshift64(&rng) % targets;
+                }
+                sampler.total_ns = 0.0;
+                sampler.total_ops = 0;
+                measure_branch(&sampler, &checksum, &result);
+                if (targets == 1) {
+                    jt_base = result;
+                }
+                print_branch_row(targets == 1 ? "constant" : kind == 0 ? "round-robin" : "random",
+                                 targets, 0, &result, targets == 1 ? -1.0 :
+                                 branch_penalty(&result, branch_mix_baseline(&jt_base, &jt_base, 1.0),
+                                                kind == 1 ? 1.0 - 1.0 / targets : -1.0));
+            }
+        }
+    }
+
+    // --- BTB 용량: 서로 다른 taken jmp 사이트 수를 늘린다 ---
+    printf("\nBTB capacity sweep (unconditional taken jmp, %d B apart):\n", BTB_SITE_SPACING);
+    printf("%8s %10s %10s %8s %9s %7s\n", "Sites", "Code(KB)", "Cycles/br", "ns/br", "BrMis/br", "CI(%)");
+    {
+        branch_result_t btb[BTB_POINT_COUNT];
+
+        for (int i = 0; i < BTB_POINT_COUNT; i++) {
+            unsigned repeats = BTB_BRANCHES_PER_SAMPLE / btb_points[i].sites;
+            branch_sampler_t sampler = {
+                .pass = btb_points[i].pass, .arg = repeats,
+                .ops = (uint64_t)repeats * btb_points[i].sites,
+            };
+
+            measure_branch(&sampler, &checksum, &btb[i]);
+            printf("%8u %10.1f %10.3f %8.3f", btb_points[i].sites,
+                   btb_points[i].sites * BTB_SITE_SPACING / 1024.0,
+                   btb[i].cycles, btb[i].ns);
+            bench_perf_print_value(btb[i].misses, 9, 4);
+            printf(" %6.2f%s\n", btb[i].stats.ci_percent, btb[i].stats.converged ? "" : "*");
+            fflush(stdout);
+        }
+
+        printf("\nBTB cliffs (>%.0f%% increase between neighbouring site counts):\n",
+               (SWEEP_CLIFF_RATIO - 1.0) * 100.0);
+        for (int i = 1; i < BTB_POINT_COUNT; i++) {
+            if (btb[i].cycles > btb[i - 1].cycles * SWEEP_CLIFF_RATIO) {
+                printf("  %u -> %u sites: %.3f -> %.3f cycles/branch\n", btb_points[i - 1].sites,
+                       btb_points[i].sites, btb[i - 1].cycles, btb[i].cycles);
+            }
+        }
+    }
+
+    if (penalty >= 0.0) {
+        printf("\nMisprediction penalty: %.1f cycles (random 50%% vs always/never taken)\n", penalty);
+    } else {
+        printf("\nMisprediction penalty: n/a (no extra mispredicts measured for random 50%%)\n");
+    }
+
+    printf("\nNotes:\n");
+    printf("- Cycles/br include the byte load and loop overhead; the difference to the\n"
+           "  baseline (always/never taken mixed at the row's taken rate, or the constant\n"
+           "  jump target) is the prediction cost\n");
+    printf("- Penalty: extra cycles per mispredict = dCycles / dBrMis; without a branch-miss\n"
+           "  counter the expected miss rate of i.i.d. random patterns is used (min(p, 1-p),\n"
+           "  1 - 1/targets), other rows show n/a\n");
+    printf("- Jump table rows also execute one always-taken jmp back to a common exit\n");
+    printf("- BTB cliffs can also come from the L1i (compare Code(KB) with the L1i size)\n");
+    printf("- Checksum: %u\n", checksum);
+
+    free(pattern);
 }
 
-void test_memory_load_l3(test_result_t *result) {
-    strcpy(result->name, "Memory LOAD (L3)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    // 8MB 배열 (L3 캐시 크기)
-    volatile uint32_t *array = malloc(8 * 1024 * 1024);
-    for (int i = 0; i < 2 * 1024 * 1024; i++) {
-        array[i] = i;
-    }
-    
-    volatile uint32_t sum = 0;
-    int iterations = ITERATIONS / 1000;
-    
-    for (int i = 0; i < iterations / 10; i++) {
-        sum += array[i % (2 * 1024 * 1024)];
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < iterations; i++) {
-        sum += array[i % (2 * 1024 * 1024)];
+// 측정값 또는 "n/a"를 고정 폭으로 출력
+static void print_mode_value(const mode_result_t *result, double value, int width, int precision) {
+    if (result->measured) {
+        printf(" %*.*f", width, precision, value);
+    } else {
+        printf(" %*s", width, "n/a");
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / iterations;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / iterations;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    free((void*)array);
 }
 
-void test_memory_load_ram(test_result_t *result) {
-    strcpy(result->name, "Memory LOAD (RAM)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    
-    // 64MB 배열 (RAM 접근)
-    volatile uint32_t *array = malloc(64 * 1024 * 1024);
-    for (int i = 0; i < 16 * 1024 * 1024; i++) {
-        array[i] = i;
-    }
-    
-    volatile uint32_t sum = 0;
-    int iterations = ITERATIONS / 10000; // RAM 접근은 더 적은 반복
-    
-    for (int i = 0; i < iterations / 10; i++) {
-        sum += array[(i * 1024) % (16 * 1024 * 1024)]; // 스트라이드 접근으로 캐시 미스 유발
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < iterations; i++) {
-        sum += array[(i * 1024) % (16 * 1024 * 1024)];
+// 행 대표 모드: 처리량 모드가 있으면 처리량, 없으면 지연
+static const mode_result_t *primary_mode(const test_result_t *result) {
+    if (result->mode[MODE_THROUGHPUT].measured) {
+        return &result->mode[MODE_THROUGHPUT];
     }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / iterations;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / iterations;
-    result->energy_consumed = result->energy_end - result->energy_start;
-    
-    free((void*)array);
+    return &result->mode[MODE_LATENCY];
 }
 
-// ============ 분기 명령어 테스트 ============
+// 모드의 하드웨어 카운터 컬럼 출력: IPC, 명령어당 L1D/LLC/분기 미스 (없으면 n/a)
+static void print_counter_columns(const mode_result_t *result) {
+    const bench_perf_counts_t *c = &result->counters;
 
-void test_branch_instruction(test_result_t *result) {
-    strcpy(result->name, "Branch (taken)");
-    
-    uint64_t start_cycles, end_cycles;
-    struct timespec start_time, end_time;
-    volatile int counter = 0;
-    
-    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-        __asm__ volatile (
-            "cmpl $0, %0\n\t"
-            "je 1f\n\t"
-            "incl %0\n\t"
-            "1:\n\t"
-            : "+r"(counter)
-            :
-            : "cc"
-        );
-    }
-    
-    result->energy_start = get_energy_joules(0);
-    clock_gettime(CLOCK_MONOTONIC, &start_time);
-    start_cycles = rdtsc();
-    
-    for (int i = 0; i < ITERATIONS; i++) {
-        __asm__ volatile (
-            "cmpl $0, %0\n\t"
-            "je 1f\n\t"
-            "incl %0\n\t"
-            "1:\n\t"
-            : "+r"(counter)
-            :
-            : "cc"
-        );
-    }
-    
-    end_cycles = rdtsc();
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
-    result->energy_end = get_energy_joules(0);
-    
-    result->avg_cycles = (double)(end_cycles - start_cycles) / ITERATIONS;
-    result->avg_time_ns = ((end_time.tv_sec - start_time.tv_sec) * 1e9 + 
-                          (end_time.tv_nsec - start_time.tv_nsec)) / ITERATIONS;
-    result->energy_consumed = result->energy_end - result->energy_start;
+    bench_perf_print_value(bench_perf_ratio(c, BENCH_PERF_INSTRUCTIONS, BENCH_PERF_CYCLES), 6, 2);
+    bench_perf_print_value(bench_perf_per_op(c, BENCH_PERF_L1D_MISSES, result->counted_ops), 9, 4);
+    bench_perf_print_value(bench_perf_per_op(c, BENCH_PERF_LLC_MISSES, result->counted_ops), 9, 4);
+    bench_perf_print_value(bench_perf_per_op(c, BENCH_PERF_BRANCH_MISSES, result->counted_ops), 9, 4);
+}
+
+// 전체 사이클 대비 stall 사이클 비율 (%), 없으면 음수
+static double stall_percent(const bench_perf_counts_t *c, bench_perf_event_t event) {
+    double ratio = bench_perf_ratio(c, event, BENCH_PERF_CYCLES);
+    return ratio < 0.0 ? ratio : ratio * 100.0;
+}
+
+// 카테고리 내 측정된 커널의 모드별 평균 출력
+static void print_category_average(const test_result_t *results, int first, int last,
+                                   kernel_mode_t mode) {
+    double sum = 0.0;
+    int count = 0;
+
+    for (int i = first; i < last; i++) {
+        if (results[i].mode[mode].measured) {
+            sum += results[i].mode[mode].cycles_per_op;
+            count++;
+        }
+    }
+    if (count > 0) {
+        printf("%s %s Avg: %.3f cycles\n", results[first].category,
+               mode == MODE_LATENCY ? "Latency" : "Throughput", sum / count);
+    }
 }
 
 void run_comprehensive_test_suite() {
     test_result_t results[TEST_COUNT];
-    
+    static sweep_point_t sweep[SWEEP_MAX_POINTS];
+    int sweep_count = 0, skipped = 0;
+    char sweep_pages_desc[96] = "";
+
     printf("AMD Ryzen 5 5600 Comprehensive Assembly Performance Test\n");
     printf("=========================================================\n\n");
-    
-    printf("Testing %d iterations per instruction...\n\n", ITERATIONS);
-    
-    // 기본 산술 명령어들
-    printf("Running Basic Arithmetic Instructions...\n");
-    test_add_instruction(&results[0]);
-    test_sub_instruction(&results[1]);
-    test_mul_instruction(&results[2]);
-    test_div_instruction(&results[3]);
-    
-    // 논리 연산 명령어들
-    printf("Running Logical Instructions...\n");
-    test_and_instruction(&results[4]);
-    test_or_instruction(&results[5]);
-    test_xor_instruction(&results[6]);
-    
-    // 시프트 연산 명령어들
-    printf("Running Shift Instructions...\n");
-    test_shl_instruction(&results[7]);
-    test_shr_instruction(&results[8]);
-    
-    // 기본 명령어들
-    printf("Running Basic Instructions...\n");
-    test_mov_instruction(&results[9]);
-    test_cmp_instruction(&results[10]);
-    
-    // SSE/SSE2 명령어들
-    printf("Running SSE Instructions...\n");
-    test_sse_add_instruction(&results[11]);
-    test_sse_float_add_instruction(&results[12]);
-    test_sse_float_mul_instruction(&results[13]);
-    
-    // AVX/AVX2 명령어들
-    printf("Running AVX Instructions...\n");
-    test_avx_add_instruction(&results[14]);
-    test_avx_float_add_instruction(&results[15]);
-    test_avx_float_mul_instruction(&results[16]);
-    
-    // 비트 조작 명령어들
-    printf("Running Bit Manipulation Instructions...\n");
-    test_popcnt_instruction(&results[17]);
-    test_lzcnt_instruction(&results[18]);
-    
-    // 메모리 접근 명령어들
-    printf("Running Memory Access Instructions...\n");
-    test_memory_load(&results[19]);
-    test_memory_load_l2(&results[20]);
-    test_memory_load_l3(&results[21]);
-    test_memory_load_ram(&results[22]);
-    
-    // 분기 명령어들
-    printf("Running Branch Instructions...\n");
-    test_branch_instruction(&results[23]);
-    
-    // 결과 출력
+
+    printf("Testing %d iterations per instruction and mode (%s, %s)...\n",
+           ITERATIONS, mode_names[MODE_LATENCY], mode_names[MODE_THROUGHPUT]);
+    printf("Sampling: %d ops per sample, %d-%d samples, CI target %.2f%%, budget %.2fs\n\n",
+           ITERATIONS / SAMPLE_DIVISOR, sampling.min_samples, sampling.max_samples,
+           sampling.ci_percent, sampling.time_budget_s);
+
+    for (int i = 0; i < TEST_COUNT; i++) {
+        if (i == 0 || strcmp(kernels[i].category, kernels[i - 1].category) != 0) {
+            printf("Running %s...\n", kernels[i].category);
+            fflush(stdout);
+        }
+        if (!bench_cpu_has(&cpu, kernels[i].isa)) {
+            // 지원하지 않는 명령어는 실행하면 #UD로 죽으므로 이름만 남긴다
+            memset(&results[i], 0, sizeof(results[i]));
+            snprintf(results[i].name, sizeof(results[i].name), "%s", kernels[i].name);
+            results[i].category = kernels[i].category;
+            results[i].missing_isa = bench_cpu_missing(&cpu, kernels[i].isa);
+            skipped++;
+            continue;
+        }
+        run_kernel(&kernels[i], &results[i]);
+    }
+    if (sweep_max_mb > 0) {
+        printf("Running Memory Latency Sweep (4 KB..%zu MB)...\n", sweep_max_mb);
+        fflush(stdout);
+        sweep_count = run_latency_sweep(sweep, sweep_pages_desc, sizeof(sweep_pages_desc));
+    }
+
+    // 결과 출력 (Latency: 의존 체인 cycles/op, RThroughput: 독립 누산기 cycles/op)
     printf("\nComprehensive Results:\n");
-    printf("%-25s %12s %12s %12s\n", "Instruction", "Cycles", "Time(ns)", "Energy(J)");
-    printf("---------------------------------------------------------------------\n");
-    
-    for (int i = 0; i < TEST_COUNT - 1; i++) {
-        printf("%-25s %12.3f %12.3f %12.6f\n", 
-               results[i].name, 
-               results[i].avg_cycles,
-               results[i].avg_time_ns,
-               results[i].energy_consumed);
-    }
-    
-    printf("\nCache Hierarchy Analysis:\n");
-    printf("L1 Cache Access: %.3f cycles\n", results[19].avg_cycles);
-    printf("L2 Cache Access: %.3f cycles\n", results[20].avg_cycles);
-    printf("L3 Cache Access: %.3f cycles\n", results[21].avg_cycles);
-    printf("RAM Access:      %.3f cycles\n", results[22].avg_cycles);
-    
+    printf("%-25s %12s %12s %12s %12s %6s %9s %9s %9s  %-17s  %s\n", "Instruction", "Latency", "RThroughput",
+           "Time(ns)", "Energy(J)", "IPC", "L1D/op", "LLC/op", "BrMis/op", "Clock", "Category");
+    printf("----------------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+    for (int i = 0; i < TEST_COUNT; i++) {
+        const mode_result_t *lat = &results[i].mode[MODE_LATENCY];
+        const mode_result_t *tput = &results[i].mode[MODE_THROUGHPUT];
+        char isa[96];
+
+        printf("%-25s", results[i].name);
+        if (results[i].missing_isa) {
+            printf(" skipped (needs %s)\n",
+                   bench_isa_format(results[i].missing_isa, isa, sizeof(isa)));
+            continue;
+        }
+        print_mode_value(lat, lat->cycles_per_op, 12, 3);
+        print_mode_value(tput, tput->cycles_per_op, 12, 3);
+        print_mode_value(tput, tput->time_ns_per_op, 12, 3);
+        printf(" %12.6f", lat->energy_consumed + tput->energy_consumed);
+        print_counter_columns(primary_mode(&results[i]));
+        printf("  %-17s  %s\n", bench_clock_name(primary_mode(&results[i])->clock), results[i].category);
+    }
+
+    printf("\nSampling Statistics (cycles/op, * = CI target not reached):\n");
+    bench_stats_print_header("Instruction [mode]");
+    for (int i = 0; i < TEST_COUNT; i++) {
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            char label[96];
+
+            if (!results[i].mode[mode].measured) {
+                continue;
+            }
+            snprintf(label, sizeof(label), "%s [%s]", results[i].name, mode_names[mode]);
+            bench_stats_print_row(label, &results[i].mode[mode].stats);
+        }
+    }
+
+    printf("\nHardware Counters (per op, stalls as %% of cycles):\n");
+    printf("%-32s %6s %9s %9s %9s %7s %7s\n",
+           "Instruction [mode]", "IPC", "L1D/op", "LLC/op", "BrMis/op", "FE(%)", "BE(%)");
+    for (int i = 0; i < TEST_COUNT; i++) {
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            const mode_result_t *r = &results[i].mode[mode];
+            char label[96];
+
+            if (!r->measured) {
+                continue;
+            }
+            snprintf(label, sizeof(label), "%s [%s]", results[i].name, mode_names[mode]);
+            printf("%-32s", label);
+            print_counter_columns(r);
+            bench_perf_print_value(stall_percent(&r->counters, BENCH_PERF_STALL_FRONTEND), 7, 1);
+            bench_perf_print_value(stall_percent(&r->counters, BENCH_PERF_STALL_BACKEND), 7, 1);
+            printf("\n");
+        }
+    }
+
+    if (sweep_max_mb > 0) {
+        print_latency_sweep(sweep, sweep_count, sweep_pages_desc);
+    }
+
+    if (skipped > 0) {
+        printf("\nSkipped (unsupported ISA on this CPU):\n");
+        for (int i = 0; i < TEST_COUNT; i++) {
+            char isa[96];
+
+            if (results[i].missing_isa) {
+                printf("  %-25s needs %s\n", results[i].name,
+                       bench_isa_format(results[i].missing_isa, isa, sizeof(isa)));
+            }
+        }
+    }
+
     printf("\nInstruction Categories Performance:\n");
-    printf("Basic Arithmetic Avg: %.3f cycles\n", 
-           (results[0].avg_cycles + results[1].avg_cycles + results[2].avg_cycles + results[3].avg_cycles) / 4);
-    printf("Logical Operations Avg: %.3f cycles\n",
-           (results[4].avg_cycles + results[5].avg_cycles + results[6].avg_cycles) / 3);
-    printf("SIMD Integer Avg: %.3f cycles\n",
-           (results[11].avg_cycles + results[14].avg_cycles) / 2);
-    printf("SIMD Float Avg: %.3f cycles\n",
-           (results[12].avg_cycles + results[13].avg_cycles + results[15].avg_cycles + results[16].avg_cycles) / 4);
-    
+    for (int first = 0, last; first < TEST_COUNT; first = last) {
+        for (last = first; last < TEST_COUNT &&
+             strcmp(results[last].category, results[first].category) == 0; last++) {
+        }
+        print_category_average(results, first, last, MODE_LATENCY);
+        print_category_average(results, first, last, MODE_THROUGHPUT);
+    }
+
     printf("\nNotes:\n");
+    printf("- Cycles come from the clock in the Clock column: core-cycles/rdpmc counts actual\n"
+           "  core clocks, tsc/rdtscp counts constant-rate reference cycles\n");
+    printf("- Reported cycles are the median of repeated samples (outliers beyond %.1f MAD rejected)\n",
+           sampling.outlier_mads);
+    printf("- Latency: dependent chain of %d ops, cycles per op\n", CHAIN_LENGTH);
+    printf("- RThroughput: %d independent accumulators, cycles per op\n", ACCUMULATORS);
+    printf("- IPC and misses/op are counted per kernel while its body runs (throughput mode\n"
+           "  in the results table); n/a means the counter is not available on this system\n");
+    printf("- Kernels are compiled per ISA and selected at startup from CPUID; (128)/(256)/(512)\n"
+           "  is the vector width, 128-bit VADDPS/VMULPS/VPADDQ use the VEX encoding\n");
     printf("- Energy measurement requires MSR access (run as root)\n");
     printf("- Results may vary depending on system load and frequency scaling\n");
     printf("- Disable CPU frequency scaling for more consistent results\n");
-    printf("- Cache measurements show memory hierarchy performance\n");
+    printf("- Memory latency: random cyclic pointer chase, %d sizes per octave; cache levels are\n"
+           "  read at half their sysfs size, RAM at the largest size\n", SWEEP_STEPS_PER_OCTAVE);
+    printf("- The sweep buffer follows the system THP policy unless --pages is given, so RAM latency\n"
+           "  may include page walks; --tlb measures that cost per page size\n");
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    bench_sampling_print_usage(&sampling);
+    printf("  --tsc               use serialized rdtscp instead of perf core-cycle counters\n");
+    printf("  --scaling           run every kernel on 1..N pinned threads (scaling curves)\n");
+    printf("  --bandwidth         run the STREAM bandwidth suite per cache level on 1..N threads\n");
+    printf("  --branch            run the branch prediction suite (patterns, jump table, BTB sweep)\n");
+    printf("  --tlb               run the TLB sweep on 4k, thp and hugetlb pages\n");
+    printf("  --c2c               measure the core-to-core cache line round trip for every CPU pair\n");
+    printf("  --threads N         maximum thread count for --scaling/--bandwidth, CPUs in the --c2c\n"
+           "                      matrix (default: all CPUs)\n");
+    printf("  --no-isa LIST       treat comma-separated ISAs as unsupported (%s", bench_isa_names[0]);
+    for (int i = 1; i < BENCH_ISA_COUNT; i++) {
+        printf(",%s", bench_isa_names[i]);
+    }
+    printf(")\n");
+    printf("  --sweep-max MB      largest working set of the memory latency sweep (default %d, 0 = off)\n",
+           SWEEP_DEFAULT_MAX_MB);
+    printf("  --pages KIND        page size of the latency sweep buffer: default, 4k, thp, hugetlb\n"
+           "                      (hugetlb falls back to thp, thp to 4k)\n");
 }
 
-int main() {
+// 명령행 옵션 처리. 잘못된 옵션이면 0을 반환
+static int parse_options(int argc, char **argv) {
+    static const struct option options[] = {
+        BENCH_SAMPLING_LONG_OPTIONS,
+        { "tsc",     no_argument,       NULL, 't' },
+        { "scaling", no_argument,       NULL, 's' },
+        { "bandwidth", no_argument,     NULL, 'b' },
+        { "branch",  no_argument,       NULL, 'B' },
+        { "tlb",     no_argument,       NULL, 'T' },
+        { "c2c",     no_argument,       NULL, 'C' },
+        { "pages",   required_argument, NULL, 'p' },
+        { "threads", required_argument, NULL, 'n' },
+        { "sweep-max", required_argument, NULL, 'm' },
+        { "no-isa",  required_argument, NULL, 'i' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        if (opt == 't') {
+            force_tsc = 1;
+        } else if (opt == 's') {
+            scaling_mode = 1;
+        } else if (opt == 'b') {
+            bandwidth_mode = 1;
+        } else if (opt == 'B') {
+            branch_mode = 1;
+        } else if (opt == 'T') {
+            tlb_mode = 1;
+        } else if (opt == 'C') {
+            c2c_mode = 1;
+        } else if (opt == 'p') {
+            if (!bench_pages_parse(optarg, &sweep_pages)) {
+                print_usage(argv[0]);
+                return 0;
+            }
+        } else if (opt == 'n') {
+            max_threads = atoi(optarg);
+        } else if (opt == 'm') {
+            sweep_max_mb = strtoul(optarg, NULL, 10);
+        } else if (opt == 'i') {
+            if (!bench_isa_parse(optarg, &cpu.disabled)) {
+                print_usage(argv[0]);
+                return 0;
+            }
+        } else if (!bench_sampling_handle_option(&sampling, opt, optarg)) {
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+    return bench_sampling_validate(&sampling);
+}
+
+int main(int argc, char **argv) {
+    bench_cpu_detect(&cpu);
+    if (!parse_options(argc, argv)) {
+        return 1;
+    }
+
     // CPU 정보 확인
     system("echo 'CPU Info:' && cat /proc/cpuinfo | grep 'model name' | head -1");
+    bench_cpu_describe(&cpu);
+    bench_timer_init(&timer, force_tsc);
+    bench_timer_describe(&timer);
+
+    // 카운터는 커널마다 다시 열지만, 사용 가능한 이벤트는 미리 한 번 보여준다
+    bench_perf_t probe;
+    bench_perf_open(&probe);
+    bench_perf_describe(&probe);
+    bench_perf_close(&probe);
     printf("\n");
-    
-    run_comprehensive_test_suite();
-    
+
+    if (scaling_mode) {
+        run_scaling_suite();
+    } else if (bandwidth_mode) {
+        run_bandwidth_suite();
+    } else if (branch_mode) {
+        run_branch_suite();
+    } else if (tlb_mode) {
+        run_tlb_suite();
+    } else if (c2c_mode) {
+        run_c2c_suite();
+    } else {
+        run_comprehensive_test_suite();
+    }
+
+    bench_timer_close(&timer);
     return 0;
 }
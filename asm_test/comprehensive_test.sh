@@ -9,7 +9,7 @@ echo "1. Checking system requirements..."
 
 # CPU 기능 확인
 echo "CPU Features:"
-cat /proc/cpuinfo | grep flags | head -1 | grep -o -E "(sse2|avx2|popcnt|lzcnt)" | sort -u
+cat /proc/cpuinfo | grep flags | head -1 | grep -o -w -E "(sse2|avx|avx2|fma|avx512f|popcnt|abm)" | sort -u
 echo ""
 
 # 시스템 최적화
@@ -26,21 +26,27 @@ sudo cpupower frequency-set --governor performance 2>/dev/null || echo "Warning:
 
 # 고우선순위로 실행
 echo "3. Running tests with high priority..."
-sudo nice -n -20 bash << 'EOF'
+# RUNS: 프로세스 실행 횟수, SAMPLING_ARGS: 프로세스 내 샘플링 옵션 (--ci, --budget 등)
+RUNS=${RUNS:-1}
+SAMPLING_ARGS=${SAMPLING_ARGS:-"--ci 1 --budget 1"}
+sudo nice -n -20 env RUNS="$RUNS" SAMPLING_ARGS="$SAMPLING_ARGS" bash << 'EOF'
 
 # 메모리 정리
 echo "Cleaning system memory..."
 sync
 echo 3 > /proc/sys/vm/drop_caches
 
-# 여러 번 실행하여 일관성 확인
-echo "4. Running multiple test iterations..."
+# 각 커널은 프로세스 안에서 신뢰구간이 수렴할 때까지 반복 샘플링된다
+echo "4. Running test iterations (sampling: $SAMPLING_ARGS)..."
 
-for i in {1..3}; do
-    echo "=== Test Run $i/3 ==="
-    ./asm_perf_test > "comprehensive_result_$i.txt"
+rm -f comprehensive_result_*.txt
+for i in $(seq 1 "$RUNS"); do
+    echo "=== Test Run $i/$RUNS ==="
+    ./asm_perf_test $SAMPLING_ARGS > "comprehensive_result_$i.txt"
     echo "Completed run $i"
-    sleep 5  # 시스템이 안정화될 시간
+    if [ "$i" -lt "$RUNS" ]; then
+        sleep 5  # 시스템이 안정화될 시간
+    fi
 done
 
 echo "5. Analyzing results..."
@@ -59,45 +65,105 @@ def parse_result_file(filename):
     # 메인 결과 테이블 파싱
     lines = content.split('\n')
     parsing_main = False
+    parsing_sampling = False
+    parsing_counters = False
+    parsing_sweep = False
     parsing_cache = False
     parsing_category = False
+    category_column = None
     
     cache_results = {}
     category_results = {}
+    sampling_results = {}
+    sweep_results = {}
     
     for line in lines:
         # 메인 테이블 파싱
-        if "Instruction" in line and "Cycles" in line and "Time(ns)" in line:
+        if "Instruction" in line and "RThroughput" in line and "Time(ns)" in line:
             parsing_main = True
+            # 마지막 Category 컬럼은 공백을 포함하므로 헤더 위치로 잘라낸다
+            category_column = line.find("Category")
             continue
         elif parsing_main and "----" in line:
             continue
-        elif parsing_main and "Cache Hierarchy Analysis:" in line:
+        elif parsing_main and "Sampling Statistics" in line:
             parsing_main = False
+            parsing_sampling = True
+            continue
+        elif parsing_sampling and "Hardware Counters" in line:
+            parsing_sampling = False
+            parsing_counters = True
+            continue
+        elif parsing_counters and "Memory Latency Sweep" in line:
+            parsing_counters = False
+            parsing_sweep = True
+            continue
+        elif parsing_counters:
+            # 모드별 카운터 상세는 결과 파일에서 직접 확인한다
+            continue
+        elif parsing_sweep and "Cache Hierarchy Analysis:" in line:
+            parsing_sweep = False
             parsing_cache = True
             continue
+        elif parsing_sweep and line.strip():
+            # "크기 Cycles/load ns/load CI(%)" (크기 예: "4.0 KB"), 절벽 요약 줄은 건너뛴다
+            parts = line.rsplit(None, 3)
+            if len(parts) == 4:
+                try:
+                    sweep_results[parts[0].strip()] = float(parts[1])
+                except ValueError:
+                    pass
+            continue
+        elif parsing_sampling and line.strip() and not line.startswith("Instruction"):
+            # "이름 [mode] N Out Min Median Mean P90 P99 MAD CI(%)" (미수렴 시 CI 뒤에 *)
+            parts = line.rsplit(None, 9)
+            match = re.match(r'^(.*) \[(\w+)\]$', parts[0].strip())
+            if match and len(parts) == 10:
+                instruction, mode = match.groups()
+                stats = sampling_results.setdefault(instruction, {})
+                stats[mode] = {
+                    'mad': float(parts[8]),
+                    'ci': float(parts[9].rstrip('*')),
+                    'converged': not parts[9].endswith('*'),
+                }
+            continue
         elif parsing_cache and "Instruction Categories Performance:" in line:
             parsing_cache = False
             parsing_category = True
             continue
         elif parsing_main and line.strip():
-            parts = line.split()
-            if len(parts) >= 4 and not line.startswith("Notes"):
+            # 이름에 공백이 있으므로 (예: "ADD (32-bit)") 오른쪽 9개 컬럼만 분리
+            # 컬럼: Latency, RThroughput, Time(ns), Energy(J), IPC, L1D/op, LLC/op, BrMis/op, Clock
+            # 측정 불가 모드나 사용할 수 없는 카운터는 "n/a". 그 뒤에 Category (하네스 레지스트리 값)
+            category = 'Uncategorized'
+            if category_column is not None and category_column >= 0:
+                category = line[category_column:].strip() or category
+                line = line[:category_column]
+            parts = line.rsplit(None, 9)
+            if len(parts) >= 10 and not line.startswith("Notes"):
                 try:
-                    instruction = parts[0]
-                    cycles = float(parts[1])
-                    time_ns = float(parts[2])
-                    energy = float(parts[3]) if parts[3] != '0.000000' else 0
+                    instruction = parts[0].strip()
+                    latency = float(parts[1]) if parts[1] != 'n/a' else None
+                    cycles = float(parts[2])
+                    time_ns = float(parts[3])
+                    energy = float(parts[4]) if parts[4] != '0.000000' else 0
                     results[instruction] = {
+                        'latency': latency,
                         'cycles': cycles,
                         'time': time_ns,
-                        'energy': energy
+                        'energy': energy,
+                        'ipc': float(parts[5]) if parts[5] != 'n/a' else None,
+                        'l1d_miss': float(parts[6]) if parts[6] != 'n/a' else None,
+                        'llc_miss': float(parts[7]) if parts[7] != 'n/a' else None,
+                        'branch_miss': float(parts[8]) if parts[8] != 'n/a' else None,
+                        'clock': parts[9],
+                        'category': category
                     }
                 except ValueError:
                     continue
         elif parsing_cache and ":" in line:
             # 캐시 결과 파싱
-            if "Cache Access:" in line or "RAM Access:" in line:
+            if "Access:" in line:
                 parts = line.split(":")
                 if len(parts) == 2:
                     cache_type = parts[0].strip()
@@ -117,7 +183,12 @@ def parse_result_file(filename):
                 except ValueError:
                     continue
     
-    return results, cache_results, category_results
+    # 프로세스 내 샘플링 통계 (처리량 모드 우선)를 메인 결과에 병합
+    for instruction, modes in sampling_results.items():
+        if instruction in results:
+            results[instruction].update(modes.get('throughput') or modes.get('latency'))
+
+    return results, cache_results, category_results, sweep_results
 
 # 모든 결과 파일 분석
 files = glob.glob("comprehensive_result_*.txt")
@@ -128,13 +199,15 @@ if not files:
 all_results = []
 all_cache_results = []
 all_category_results = []
+all_sweep_results = []
 
 for filename in files:
     try:
-        results, cache_results, category_results = parse_result_file(filename)
+        results, cache_results, category_results, sweep_results = parse_result_file(filename)
         all_results.append(results)
         all_cache_results.append(cache_results)
         all_category_results.append(category_results)
+        all_sweep_results.append(sweep_results)
     except Exception as e:
         print(f"Error parsing {filename}: {e}")
 
@@ -154,22 +227,33 @@ def calculate_averages(data_list):
             if isinstance(values[0], dict):
                 # 메인 결과 (딕셔너리)
                 avg_cycles = sum(v['cycles'] for v in values) / len(values)
+                latencies = [v['latency'] for v in values if v.get('latency') is not None]
+                avg_latency = sum(latencies) / len(latencies) if latencies else None
                 avg_time = sum(v['time'] for v in values) / len(values)
                 avg_energy = sum(v['energy'] for v in values) / len(values)
-                
-                # 표준편차 계산
-                if len(values) > 1:
-                    mean_cycles = avg_cycles
-                    variance = sum((v['cycles'] - mean_cycles) ** 2 for v in values) / len(values)
-                    stddev = variance ** 0.5
-                else:
-                    stddev = 0
-                
+
+                # 하드웨어 카운터 (n/a인 실행은 제외)
+                counters = {}
+                for counter in ('ipc', 'l1d_miss', 'llc_miss', 'branch_miss'):
+                    counted = [v[counter] for v in values if v.get(counter) is not None]
+                    counters[counter] = sum(counted) / len(counted) if counted else None
+
+                # 프로세스 내 샘플링 통계 (실행 간 최댓값)
+                ci = max(v.get('ci', 0.0) for v in values)
+                mad = max(v.get('mad', 0.0) for v in values)
+                converged = all(v.get('converged', True) for v in values)
+
                 averages[key] = {
+                    'latency': avg_latency,
                     'cycles': avg_cycles,
                     'time': avg_time,
                     'energy': avg_energy,
-                    'stddev': stddev
+                    'ci': ci,
+                    'mad': mad,
+                    'clock': values[0].get('clock', 'unknown'),
+                    'category': values[0].get('category', 'Uncategorized'),
+                    'converged': converged,
+                    **counters
                 }
             else:
                 # 캐시/카테고리 결과 (숫자)
@@ -180,49 +264,57 @@ def calculate_averages(data_list):
 avg_results = calculate_averages(all_results)
 avg_cache = calculate_averages(all_cache_results)
 avg_category = calculate_averages(all_category_results)
+avg_sweep = calculate_averages(all_sweep_results)
 
 # 결과 출력
 print("COMPREHENSIVE PERFORMANCE ANALYSIS")
 print("="*60)
 print(f"Runs analyzed: {len(files)}")
+print("Cycle clock: " + ", ".join(sorted({data['clock'] for data in avg_results.values()})))
 print()
 
 print("INSTRUCTION PERFORMANCE (Average of {} runs):".format(len(files)))
-print("%-25s %10s %10s %10s %8s" % ("Instruction", "Cycles", "Time(ns)", "Energy(J)", "StdDev"))
-print("-" * 75)
-
-# 카테고리별로 정렬하여 출력
-categories = {
-    'Basic Arithmetic': ['ADD', 'SUB', 'IMUL', 'DIV'],
-    'Logical Operations': ['AND', 'OR', 'XOR'],
-    'Shift Operations': ['SHL', 'SHR'],
-    'Basic Instructions': ['MOV', 'CMP'],
-    'SSE Instructions': ['SSE2', 'SSE'],
-    'AVX Instructions': ['AVX2', 'AVX'],
-    'Bit Manipulation': ['POPCNT', 'LZCNT'],
-    'Memory Access': ['Memory'],
-    'Branch Instructions': ['Branch']
-}
-
-for category, keywords in categories.items():
-    category_items = []
-    for instruction, data in avg_results.items():
-        if any(keyword in instruction for keyword in keywords):
-            category_items.append((instruction, data))
-    
+print("%-25s %10s %10s %10s %10s %8s %8s %6s %9s %9s" % ("Instruction", "Latency", "RThru", "Time(ns)", "Energy(J)",
+                                                         "MAD", "CI(%)", "IPC", "L1D/op", "LLC/op"))
+print("-" * 122)
+
+def format_counter(value, width, precision):
+    return "%*.*f" % (width, precision, value) if value is not None else "%*s" % (width, "n/a")
+
+# 하네스가 출력한 Category 컬럼으로 묶어서 출력 (카테고리 순서는 결과 파일 순서)
+categories = []
+for results in all_results:
+    for data in results.values():
+        if data['category'] not in categories:
+            categories.append(data['category'])
+
+for category in categories:
+    category_items = [(instruction, data) for instruction, data in avg_results.items()
+                      if data['category'] == category]
+
     if category_items:
         print(f"\n{category}:")
         for instruction, data in sorted(category_items):
-            print("%-25s %10.3f %10.3f %10.6f %8.3f" % 
-                  (instruction, data['cycles'], data['time'], data['energy'], data['stddev']))
+            latency = "%10.3f" % data['latency'] if data['latency'] is not None else "%10s" % "n/a"
+            print("%-25s %s %10.3f %10.3f %10.6f %8.3f %7.2f%s %s %s %s" %
+                  (instruction, latency, data['cycles'], data['time'], data['energy'],
+                   data['mad'], data['ci'], "" if data['converged'] else "*",
+                   format_counter(data['ipc'], 6, 2), format_counter(data['l1d_miss'], 9, 4),
+                   format_counter(data['llc_miss'], 9, 4)))
 
 print("\nCACHE HIERARCHY PERFORMANCE:")
 print("-" * 40)
 if avg_cache:
-    cache_order = ['L1 Cache Access', 'L2 Cache Access', 'L3 Cache Access', 'RAM Access']
-    for cache_type in cache_order:
-        if cache_type in avg_cache:
-            print(f"{cache_type:20s}: {avg_cache[cache_type]:6.1f} cycles")
+    for cache_type, cycles in sorted(avg_cache.items()):
+        print(f"{cache_type:25s}: {cycles:6.1f} cycles")
+
+print("\nMEMORY LATENCY CURVE (random pointer chase):")
+print("-" * 40)
+def size_bytes(label):
+    value, unit = label.split()
+    return float(value) * {'KB': 1 << 10, 'MB': 1 << 20, 'GB': 1 << 30}[unit]
+for size, cycles in sorted(avg_sweep.items(), key=lambda item: size_bytes(item[0])):
+    print(f"{size:>12s}: {cycles:8.1f} cycles")
 
 print("\nINSTRUCTION CATEGORY AVERAGES:")
 print("-" * 40)
@@ -238,16 +330,16 @@ if avg_results:
     fastest = min(avg_results.items(), key=lambda x: x[1]['cycles'])
     slowest = max(avg_results.items(), key=lambda x: x[1]['cycles'])
     
-    print(f"Fastest instruction: {fastest[0]} ({fastest[1]['cycles']:.3f} cycles)")
-    print(f"Slowest instruction: {slowest[0]} ({slowest[1]['cycles']:.3f} cycles)")
+    print(f"Fastest instruction (throughput): {fastest[0]} ({fastest[1]['cycles']:.3f} cycles)")
+    print(f"Slowest instruction (throughput): {slowest[0]} ({slowest[1]['cycles']:.3f} cycles)")
     print(f"Performance ratio: {slowest[1]['cycles']/fastest[1]['cycles']:.1f}x")
 
 # 일관성 분석
-inconsistent = [(name, data['stddev']) for name, data in avg_results.items() if data['stddev'] > 0.1]
+inconsistent = [(name, data['ci']) for name, data in avg_results.items() if not data['converged']]
 if inconsistent:
-    print(f"\nInconsistent measurements (StdDev > 0.1):")
-    for name, stddev in sorted(inconsistent, key=lambda x: x[1], reverse=True)[:5]:
-        print(f"  {name}: {stddev:.3f}")
+    print(f"\nInconsistent measurements (CI target not reached within budget):")
+    for name, ci in sorted(inconsistent, key=lambda x: x[1], reverse=True)[:5]:
+        print(f"  {name}: ±{ci:.2f}%")
 
 # SIMD 효율성 분석
 sse_avg = sum(data['cycles'] for name, data in avg_results.items() if 'SSE' in name) / max(1, len([name for name in avg_results if 'SSE' in name]))
@@ -278,7 +370,7 @@ sudo cpupower frequency-set --governor schedutil 2>/dev/null || true
 
 echo ""
 echo "7. Comprehensive testing completed!"
-echo "Individual results saved as comprehensive_result_1.txt through comprehensive_result_3.txt"
+echo "Individual results saved as comprehensive_result_<run>.txt"
 echo ""
 echo "System Analysis Summary:"
 echo "========================"
@@ -1,56 +1,342 @@
 #!/usr/bin/env python3
+import array
 import random
 import os
 import subprocess
 import time
 
 
+# 반복당 본문 복제 횟수로 허용하는 값
+SUPPORTED_UNROLL = (1, 4, 16, 64)
+
+# 루프 오버헤드 측정용 빈 본문 커널 이름
+BASELINE_TEST = "baseline"
+MIX_BASELINE = "baseline"           # 조합 커널은 test_mix_ 접두어가 붙는다
+
+# 테스트 데이터와 인덱스 테이블을 담는 바이너리 파일 (.incbin으로 포함)
+DATA_BLOB = "benchmark_data.bin"
+
+# 랜덤 인덱스 테이블 원소 수 (2의 거듭제곱, 반복 횟수와 무관하게 고정)
+INDEX_TABLE_SIZE = 1 << 16
+
+# 명령어 조합(mix) 커널: 반복당 조합 복제 횟수와 목적지 레지스터 풀.
+# 풀은 명령어 종류별로 MIX_CHAINS개씩 나눠 주므로 서로 다른 종류끼리는 의존하지 않고,
+# 단일 측정과 조합 모두 종류마다 같은 수의 독립 체인이 생긴다. MIX_CHAINS는 지연 x 처리량
+# (imul/popcnt/lzcnt 3x1, 단순 ALU 1x4) 이상이어야 지연이 아닌 포트가 병목이 된다.
+MIX_UNROLL = 16
+MIX_CHAINS = 4
+MIX_REGISTERS = ("%rax", "%rbx", "%rsi", "%rdi", "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15")
+MIX_MAX_PARTS = len(MIX_REGISTERS) // MIX_CHAINS
+# 쌍 조합 시간이 max(개별)에 가까우면 포트 독립, 합에 가까우면 포트 공유
+CONTENTION_SHARED = 0.5
+# 경합 비율이 0..100%에서 이만큼 넘게 벗어나면 잡음/모델 밖이라 판정하지 않는다
+CONTENTION_MARGIN = 0.1
+
+
+def next_power_of_two(value):
+    """value 이상인 가장 작은 2의 거듭제곱"""
+    return 1 << max(0, value - 1).bit_length()
+
+
+def parse_mix(spec, known):
+    """"imul:2, popcnt:1, add:3" -> [("imul", 2), ("popcnt", 1), ("add", 3)]
+
+    개수를 생략하면 1. 같은 명령어가 두 번 나오면 개수를 합친다.
+    """
+    parts = {}
+    for item in spec.split(","):
+        item = item.strip()
+        if not item:
+            continue
+        name, _, count = item.partition(":")
+        name = name.strip()
+        if name not in known:
+            raise ValueError(f"unknown mix instruction '{name}' (known: {', '.join(known)})")
+        try:
+            count = int(count) if count.strip() else 1
+        except ValueError:
+            raise ValueError(f"bad count in mix item '{item}'") from None
+        if count < 1:
+            raise ValueError(f"mix count must be >= 1: '{item}'")
+        parts[name] = parts.get(name, 0) + count
+    if not parts:
+        raise ValueError(f"empty mix specification: '{spec}'")
+    if len(parts) > MIX_MAX_PARTS:
+        raise ValueError(f"a mix may use at most {MIX_MAX_PARTS} instructions")
+    return list(parts.items())
+
+
+def mix_label(parts):
+    return " ".join(f"{name}:{count}" for name, count in parts)
+
+
 class AssemblyBenchmarkGenerator:
-    def __init__(self, data_size=100000, iterations=1000000):
-        self.data_size = data_size
+    # 명령어별 테스트 본문 (code는 반복당 unroll번 복제된다, ops는 code의 명령어 수).
+    # 본문은 %rax를 통해 반복 사이로 이어지는 의존 체인(지연)이거나, 결과를 쓰지 않는
+    # 독립 명령어(cmp, 저장: 처리량)다. 루프가 매 반복 읽는 랜덤 인덱스(%r11)에는
+    # 의존하지 않고, 랜덤 데이터(%rdx)는 소스로만 쓴다. %rbx, %r9는 본문 전용.
+    INSTRUCTION_TESTS = {
+        "add": {
+            "code": "    add %rdx, %rax\n    add $1, %rax",
+            "ops": 2,
+            "setup": "xor %rax, %rax"
+        },
+        "sub": {
+            "code": "    sub %rdx, %rax\n    sub $1, %rax",
+            "ops": 2,
+            "setup": "mov $0xFFFFFFFF, %rax"
+        },
+        "mul": {
+            "code": "    mul %rbx",
+            "ops": 1,
+            "setup": "mov $0x12345, %rax\n    mov $3, %rbx"
+        },
+        "imul": {
+            "code": "    imul %rdx, %rax",
+            "ops": 1,
+            "setup": "mov $0x12345, %rax"
+        },
+        "div": {
+            # 나누는 수가 1이라 몫(%rax)이 매번 같은 크기로 유지된다
+            "code": "    xor %rdx, %rdx\n    div %rbx",
+            "ops": 2,
+            "setup": "mov $0x123456789, %rax\n    mov $1, %rbx"
+        },
+        "mov": {
+            "code": "    mov %rax, %rbx\n    mov %rbx, %r9\n    mov %r9, %rax",
+            "ops": 3,
+            "setup": "xor %rax, %rax"
+        },
+        "cmp": {
+            "code": "    cmp %rdx, %rax\n    cmp $0x12345, %rax",
+            "ops": 2,
+            "setup": "xor %rax, %rax"
+        },
+        "and": {
+            "code": "    and %rdx, %rax\n    and $0xFFFF, %rax",
+            "ops": 2,
+            "setup": "mov $-1, %rax"
+        },
+        "or": {
+            "code": "    or %rdx, %rax\n    or $0xF0F0, %rax",
+            "ops": 2,
+            "setup": "xor %rax, %rax"
+        },
+        "xor": {
+            "code": "    xor %rdx, %rax\n    xor $0xAAAA, %rax",
+            "ops": 2,
+            "setup": "xor %rax, %rax"
+        },
+        "shl": {
+            "code": "    shl $1, %rax\n    shl $2, %rax",
+            "ops": 2,
+            "setup": "mov $-1, %rax"
+        },
+        "shr": {
+            "code": "    shr $1, %rax\n    shr $2, %rax",
+            "ops": 2,
+            "setup": "mov $-1, %rax"
+        },
+        "lea": {
+            "code": "    lea (%rax,%rdx,2), %rax\n    lea 8(%rax), %rax",
+            "ops": 2,
+            "setup": "xor %rax, %rax"
+        },
+        "memory_load": {
+            # test_data는 하나의 랜덤 순환이므로 로드 결과가 다음 로드의 인덱스 (L2 크기 추적)
+            "code": "    mov (%rsi,%rax,8), %rax",
+            "ops": 1,
+            "setup": "xor %rax, %rax"
+        },
+        "memory_store": {
+            "code": "    mov %rdx, (%rbx)\n    mov %rax, 8(%rbx)",
+            "ops": 2,
+            "setup": "xor %rax, %rax\n    lea store_scratch(%rip), %rbx"
+        }
+    }
+
+    # 포트 경합 분석용 명령어 (처리량 형태). {dst}는 종류별 MIX_REGISTERS 몫에서 돌아가며 배정되고
+    # 소스는 항상 %rdx(상수)다. mul/div/mov처럼 고정 레지스터를 쓰거나 rename 단계에서
+    # 사라지는 명령어는 제외한다. load/store는 테스트 데이터(랜덤 순환)가 아닌 mix_scratch를
+    # 쓴다. isa는 생성된 드라이버가 실행 전에 확인한다.
+    MIX_INSTRUCTIONS = {
+        "add":    {"code": "add %rdx, {dst}"},
+        "sub":    {"code": "sub %rdx, {dst}"},
+        "and":    {"code": "and %rdx, {dst}"},
+        "or":     {"code": "or %rdx, {dst}"},
+        "xor":    {"code": "xor %rdx, {dst}"},
+        "cmp":    {"code": "cmp %rdx, {dst}"},
+        "shl":    {"code": "shl $1, {dst}"},
+        "shr":    {"code": "shr $1, {dst}"},
+        "imul":   {"code": "imul %rdx, {dst}"},
+        "lea":    {"code": "lea (%rdx,{dst},2), {dst}"},
+        "popcnt": {"code": "popcnt %rdx, {dst}", "isa": "BENCH_ISA_POPCNT"},
+        "lzcnt":  {"code": "lzcnt %rdx, {dst}", "isa": "BENCH_ISA_LZCNT"},
+        "load":   {"code": "mov mix_scratch(%rip), {dst}"},
+        "store":  {"code": "mov {dst}, mix_scratch+64(%rip)"},
+    }
+
+    def __init__(self, data_size=100000, iterations=1000000, unroll=16, mixes=None, pairwise=False):
+        if unroll not in SUPPORTED_UNROLL:
+            raise ValueError(f"unroll must be one of {SUPPORTED_UNROLL}, got {unroll}")
+        # 루프의 and 마스크가 정확하도록 데이터 크기는 2의 거듭제곱으로 올림
+        self.data_size = next_power_of_two(data_size)
         self.iterations = iterations
-        self.random_data = []
-        self.random_addresses = []
+        self.unroll = unroll
+        self.mixes = self.build_mixes([parse_mix(spec, self.MIX_INSTRUCTIONS) for spec in mixes or []],
+                                      pairwise)
+
+    def build_mixes(self, custom, pairwise):
+        """측정할 조합 목록: 단일 명령어(기준) -> 모든 쌍(pairwise) -> 사용자 조합 순.
+
+        각 항목은 (parts, kind)이며 kind는 "single", "pair", "custom".
+        단일 명령어는 조합에 쓰인 명령어(pairwise면 등록된 전체)마다 하나씩 둔다.
+        """
+        if not custom and not pairwise:
+            return []
+        if pairwise:
+            names = list(self.MIX_INSTRUCTIONS)
+        else:
+            names = [name for name in self.MIX_INSTRUCTIONS
+                     if any(name == part for parts in custom for part, _ in parts)]
+        mixes = [([(name, 1)], "single") for name in names]
+        if pairwise:
+            for i, a in enumerate(names):
+                for b in names[i + 1:]:
+                    mixes.append(([(a, 1), (b, 1)], "pair"))
+        mixes += [(parts, "custom") for parts in custom]
+        return mixes
+
+    @property
+    def mix_iterations(self):
+        # 조합 커널은 반복당 MIX_UNROLL번 복제하므로 전체 명령어 수를 단일 테스트와 맞춘다
+        return max(1, self.iterations // MIX_UNROLL)
+
+    def mix_sequence(self, parts):
+        """조합 1회분 명령어 이름 목록. 개수 비율을 유지하며 라운드 로빈으로 섞는다.
+        ("imul", 2), ("add", 3) -> imul add imul add add"""
+        remaining = dict(parts)
+        sequence = []
+        while any(remaining.values()):
+            for name, _ in parts:
+                if remaining[name]:
+                    sequence.append(name)
+                    remaining[name] -= 1
+        return sequence
+
+    @staticmethod
+    def mix_registers(parts):
+        """명령어 종류별 목적지 레지스터 몫. 종류 수와 무관하게 MIX_CHAINS개씩 겹치지 않게 나눈다."""
+        return {name: MIX_REGISTERS[i * MIX_CHAINS:(i + 1) * MIX_CHAINS] for i, (name, _) in enumerate(parts)}
+
+    def create_mix_test(self, index, parts):
+        """명령어 조합 커널 생성. 상수 %rdx를 소스로, 종류마다 자기 레지스터 몫을 돌아가며
+        목적지로 써서 종류 안에서만 독립 체인을 만든다 (다른 종류의 결과를 읽지 않음).
+        랜덤 로드가 없는 빡빡한 루프라서 처리량(포트)만 본다. parts가 비면 루프 카운터
+        (dec/jnz)만 남는 기준선 커널이 되고, 드라이버가 그 중앙값을 조합마다 뺀다."""
+        registers = self.mix_registers(parts)
+        used = dict.fromkeys(registers, 0)
+        lines = []
+        for name in self.mix_sequence(parts) * MIX_UNROLL:
+            dst = registers[name][used[name] % len(registers[name])]
+            used[name] += 1
+            lines.append("    " + self.MIX_INSTRUCTIONS[name]["code"].format(dst=dst))
+        body = "\n".join(lines)
+        init = "\n".join(f"    mov %rdx, {reg}" for reg in MIX_REGISTERS)
+        return f"""
+# 조합: {mix_label(parts) or "기준선 (빈 본문)"}
+.global test_mix_{index}
+test_mix_{index}:
+    push %rbp
+    mov %rsp, %rbp
+    push %rax
+    push %rbx
+    push %rcx
+    push %rdx
+    push %rsi
+    push %rdi
+    push %r8
+    push %r9
+    push %r10
+    push %r11
+    push %r12
+    push %r13
+    push %r14
+    push %r15
+
+    mov mix_iterations(%rip), %rcx
+    movabs $0x5555555555555555, %rdx  # popcnt/lzcnt 결과가 0이 아니도록
+{init}
 
-    def generate_random_data(self):
-        """캐시 미스를 위한 랜덤 데이터 생성"""
-        print(f"Generating {self.data_size} random values...")
-        self.random_data = [random.randint(1, 0xFFFFFFFF) for _ in range(self.data_size)]
+test_mix_{index}_loop:
+{body}
+    dec %rcx
+    jnz test_mix_{index}_loop
+
+    pop %r15
+    pop %r14
+    pop %r13
+    pop %r12
+    pop %r11
+    pop %r10
+    pop %r9
+    pop %r8
+    pop %rdi
+    pop %rsi
+    pop %rdx
+    pop %rcx
+    pop %rbx
+    pop %rax
+    pop %rbp
+    ret
+"""
 
-        # 메모리 접근 패턴을 예측 불가능하게 만들기 위한 랜덤 인덱스
-        self.random_addresses = [random.randint(0, self.data_size - 1) for _ in range(self.iterations)]
+    def generate_data_blob(self):
+        """테스트 데이터(data_size개 quad) + 인덱스 테이블(INDEX_TABLE_SIZE개 quad) 바이너리 생성
+
+        테스트 데이터는 0..data_size-1을 잇는 하나의 랜덤 순환(Sattolo)이라서
+        memory_load가 그대로 포인터 추적에 쓰고, 다른 테스트에는 랜덤 소스 값이 된다.
+        인덱스는 루프에서 data_size - 1로 마스크되므로 임의의 64비트 값이면 된다.
+        크기가 반복 횟수와 무관하므로 생성/어셈블 시간이 일정하다.
+        """
+        print(f"Generating a {self.data_size}-element random cycle + {INDEX_TABLE_SIZE} indices...")
+        cycle = list(range(self.data_size))
+        for i in range(self.data_size - 1, 0, -1):
+            j = random.randrange(i)
+            cycle[i], cycle[j] = cycle[j], cycle[i]
+        return array.array("q", cycle).tobytes() + random.randbytes(INDEX_TABLE_SIZE * 8)
 
     def create_data_section(self):
-        """데이터 섹션 생성"""
-        data_section = ".section .data\n"
-        data_section += "    .align 64\n"  # 캐시 라인 정렬
-        data_section += "test_data:\n"
-
-        # 8바이트씩 묶어서 .quad로 정의
-        for i in range(0, len(self.random_data), 2):
-            if i + 1 < len(self.random_data):
-                val1 = self.random_data[i] & 0xFFFFFFFF
-                val2 = self.random_data[i + 1] & 0xFFFFFFFF
-                combined = (val2 << 32) | val1
-                data_section += f"    .quad 0x{combined:016x}\n"
-            else:
-                val = self.random_data[i] & 0xFFFFFFFF
-                data_section += f"    .quad 0x{val:016x}\n"
-
-        data_section += "\nrandom_indices:\n"
-        for i in range(0, len(self.random_addresses), 8):
-            indices = self.random_addresses[i:i + 8]
-            while len(indices) < 8:
-                indices.append(0)
-            data_section += "    .quad " + ", ".join(str(idx) for idx in indices) + "\n"
-
-        data_section += f"\ndata_size: .quad {self.data_size}\n"
-        data_section += f"iterations: .quad {self.iterations}\n"
-
-        return data_section
+        """데이터 섹션 생성 (실제 값은 DATA_BLOB에서 .incbin)"""
+        data_bytes = self.data_size * 8
+        return f""".section .data
+    .align 64                       # 캐시 라인 정렬
+test_data:
+    .incbin "{DATA_BLOB}", 0, {data_bytes}
+
+    .align 64
+random_indices:
+    .incbin "{DATA_BLOB}", {data_bytes}, {INDEX_TABLE_SIZE * 8}
+
+    .align 64
+store_scratch:                      # memory_store 대상 (테스트 데이터와 분리)
+    .skip 64
+
+data_size: .quad {self.data_size}
+iterations: .quad {self.iterations}
+""" + (f"""mix_iterations: .quad {self.mix_iterations}
+
+    .align 64
+mix_scratch:                        # 조합 load/store 대상 (load와 store는 다른 캐시 라인)
+    .skip 128
+""" if self.mixes else "")
 
     def create_instruction_test(self, instruction_name, asm_code, setup_code="", cleanup_code=""):
-        """특정 명령어 테스트 함수 생성"""
+        """특정 명령어 테스트 함수 생성 (본문은 반복당 unroll번 복제)"""
+        if asm_code:
+            body = "\n".join([asm_code] * self.unroll)
+        else:
+            body = "    # 빈 본문: 루프 오버헤드 기준선"
         return f"""
 .global test_{instruction_name}
 test_{instruction_name}:
@@ -76,17 +362,17 @@ test_{instruction_name}:
     {setup_code}
 
 test_{instruction_name}_loop:
-    # 랜덤 메모리 접근으로 캐시 무력화
-    mov (%rdi,%r8,8), %rax          # 랜덤 인덱스 로드
-    and $0x{(self.data_size - 1):x}, %rax    # 범위 제한
-    mov (%rsi,%rax,8), %rdx         # 랜덤 데이터 로드
+    # 랜덤 메모리 접근으로 캐시 무력화 (본문의 %rax 체인과는 독립)
+    mov (%rdi,%r8,8), %r11          # 랜덤 인덱스 로드
+    and $0x{(self.data_size - 1):x}, %r11    # 범위 제한
+    mov (%rsi,%r11,8), %rdx         # 랜덤 데이터 로드
 
-    # 실제 테스트할 명령어들
-{asm_code}
+    # 실제 테스트할 명령어들 (x{self.unroll})
+{body}
 
     # 다음 반복
     inc %r8
-    and $0x{(len(self.random_addresses) - 1):x}, %r8  # 인덱스 순환
+    and $0x{(INDEX_TABLE_SIZE - 1):x}, %r8  # 인덱스 순환
     dec %rcx
     jnz test_{instruction_name}_loop
 
@@ -112,72 +398,10 @@ test_{instruction_name}_loop:
         asm_content = self.create_data_section()
         asm_content += "\n.section .text\n"
 
-        # 다양한 명령어 테스트들
-        tests = {
-            "add": {
-                "code": "    add %rdx, %rax\n    add $1, %rax",
-                "setup": "xor %rax, %rax"
-            },
-            "sub": {
-                "code": "    sub %rdx, %rax\n    sub $1, %rax",
-                "setup": "mov $0xFFFFFFFF, %rax"
-            },
-            "mul": {
-                "code": "    mov %rdx, %rax\n    mul %rdx",
-                "setup": "",
-                "cleanup": "# mul result in rdx:rax"
-            },
-            "imul": {
-                "code": "    imul %rdx, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "div": {
-                "code": "    xor %rdx, %rdx\n    div %rbx",
-                "setup": "mov $0xFFFFFFFF, %rax\n    mov $0x12345, %rbx\n    or $1, %rbx"
-            },
-            "mov": {
-                "code": "    mov %rdx, %rax\n    mov %rax, %rbx\n    mov %rbx, %r9",
-                "setup": ""
-            },
-            "cmp": {
-                "code": "    cmp %rdx, %rax\n    cmp $0x12345, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "and": {
-                "code": "    and %rdx, %rax\n    and $0xFFFF, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "or": {
-                "code": "    or %rdx, %rax\n    or $0xF0F0, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "xor": {
-                "code": "    xor %rdx, %rax\n    xor $0xAAAA, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "shl": {
-                "code": "    shl $1, %rax\n    shl $2, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "shr": {
-                "code": "    shr $1, %rax\n    shr $2, %rax",
-                "setup": "mov %rdx, %rax"
-            },
-            "lea": {
-                "code": "    lea (%rsi,%rdx,2), %rax\n    lea 8(%rax), %rbx",
-                "setup": ""
-            },
-            "memory_load": {
-                "code": "    mov (%rsi,%rax,8), %rbx\n    mov 8(%rsi,%rax,8), %r9",
-                "setup": ""
-            },
-            "memory_store": {
-                "code": "    mov %rdx, (%rsi,%rax,8)\n    mov %rax, 8(%rsi,%rax,8)",
-                "setup": ""
-            }
-        }
+        # 루프 오버헤드 기준선 (빈 본문) + 명령어 테스트들
+        asm_content += self.create_instruction_test(BASELINE_TEST, "")
 
-        for name, test in tests.items():
+        for name, test in self.INSTRUCTION_TESTS.items():
             asm_content += self.create_instruction_test(
                 name,
                 test["code"],
@@ -185,37 +409,270 @@ test_{instruction_name}_loop:
                 test.get("cleanup", "")
             )
 
+        if self.mixes:
+            asm_content += self.create_mix_test(MIX_BASELINE, [])
+        for index, (parts, _) in enumerate(self.mixes):
+            asm_content += self.create_mix_test(index, parts)
+
         return asm_content
 
+    def create_mix_driver(self):
+        """조합 측정 표, 예측/경합 계산, 경합 행렬 출력 (조합이 있을 때만 드라이버에 포함)"""
+        singles = [parts[0][0] for parts, kind in self.mixes if kind == "single"]
+        rows = []
+        for index, (parts, kind) in enumerate(self.mixes):
+            isa = sorted({self.MIX_INSTRUCTIONS[name]["isa"] for name, _ in parts
+                          if "isa" in self.MIX_INSTRUCTIONS[name]})
+            label = parts[0][0] if kind == "single" else mix_label(parts)
+            single = ", ".join(str(singles.index(name)) for name, _ in parts)
+            count = ", ".join(str(count) for _, count in parts)
+            rows.append(f'    {{ .label = "{label}", .func = test_mix_{index}, .isa = {" | ".join(isa) or "0"}, '
+                        f'.pair = {int(kind == "pair")}, .parts = {len(parts)}, '
+                        f'.single = {{ {single} }}, .count = {{ {count} }} }},')
+        mix_rows = "\n".join(rows)
+
+        return f'''
+// ============ 명령어 조합 (포트 경합) ============
+// 단일 명령어를 먼저 재고, 조합의 측정값을 두 예측과 비교한다.
+//   sum: 모든 명령어가 같은 포트를 나눠 쓸 때 (개별 시간의 합)
+//   max: 모두 다른 포트에서 겹쳐 실행될 때 (개별 시간의 최댓값)
+// contention = (측정 - max) / (sum - max): 0%면 포트 독립, 100%면 포트 공유.
+// 측정값은 모두 median(raw) - median(빈 본문 기준선)이고, 경합이 0..100%에서
+// MIX_MARGIN 넘게 벗어나면 판정하지 않고 "unresolved"로 표시한다.
+
+#define MIX_ITERATIONS {self.mix_iterations}
+#define MIX_UNROLL {MIX_UNROLL}
+#define MIX_SINGLES {len(singles)}
+#define MIX_MAX_PARTS {MIX_MAX_PARTS}
+#define MIX_SHARED {CONTENTION_SHARED}
+#define MIX_MARGIN {CONTENTION_MARGIN}
+
+// single: 조합에 든 명령어의 단일 측정 행 번호 (mixes 앞쪽 MIX_SINGLES개), count: 1회분 개수
+typedef struct {{
+    const char *label;
+    void (*func)();
+    unsigned isa;
+    int pair;                   // 1이면 경합 행렬에 들어가는 1:1 쌍
+    int parts;
+    int single[MIX_MAX_PARTS];
+    int count[MIX_MAX_PARTS];
+    bench_stats_t stats;        // 보정 전 cycles/mix
+    double cycles;              // median(raw) - median(baseline), cycles/mix
+    int skipped;
+}} mix_case_t;
+
+static mix_case_t mixes[] = {{
+{mix_rows}
+}};
+
+#define MIX_COUNT ((int)(sizeof(mixes) / sizeof(mixes[0])))
+
+// 개별 측정값으로 sum/max 예측 계산. 들어간 단일 측정이 건너뛰어졌으면 0
+static int mix_predict(const mix_case_t *mix, double *sum, double *max) {{
+    *sum = *max = 0.0;
+    for (int p = 0; p < mix->parts; p++) {{
+        const mix_case_t *single = &mixes[mix->single[p]];
+        if (single->skipped) {{
+            return 0;
+        }}
+        double t = single->cycles * mix->count[p];
+        *sum += t;
+        if (t > *max) {{
+            *max = t;
+        }}
+    }}
+    return 1;
+}}
+
+// 경합 비율 (sum과 max가 같으면, 즉 명령어가 한 종류면 NAN)
+static double mix_contention(const mix_case_t *mix) {{
+    double sum, max;
+
+    if (mix->skipped || !mix_predict(mix, &sum, &max) || sum - max < 1e-9) {{
+        return NAN;
+    }}
+    return (mix->cycles - max) / (sum - max);
+}}
+
+// 0..100% 모델로 설명되는 값인지 (여유 안쪽이면 경계로 잘라서 쓴다)
+static int mix_resolved(double contention) {{
+    return contention >= -MIX_MARGIN && contention <= 1.0 + MIX_MARGIN;
+}}
+
+static double mix_clamp(double contention) {{
+    return fmin(1.0, fmax(0.0, contention));
+}}
+
+static void print_mix_matrix(void) {{
+    double contention[MIX_SINGLES][MIX_SINGLES];
+    int shared = 0;
+
+    for (int i = 0; i < MIX_SINGLES; i++) {{
+        for (int j = 0; j < MIX_SINGLES; j++) {{
+            contention[i][j] = NAN;
+        }}
+    }}
+    for (int i = 0; i < MIX_COUNT; i++) {{
+        if (mixes[i].pair) {{
+            int a = mixes[i].single[0], b = mixes[i].single[1];
+            contention[a][b] = contention[b][a] = mix_contention(&mixes[i]);
+        }}
+    }}
+
+    printf("\\nPairwise contention matrix (0%% = independent ports, 100%% = shared port, ? = unresolved):\\n%-8s", "");
+    for (int j = 0; j < MIX_SINGLES; j++) {{
+        printf("%7s", mixes[j].label);
+    }}
+    printf("\\n");
+    for (int i = 0; i < MIX_SINGLES; i++) {{
+        printf("%-8s", mixes[i].label);
+        for (int j = 0; j < MIX_SINGLES; j++) {{
+            if (i == j) {{
+                printf("%7s", "-");
+            }} else if (isnan(contention[i][j])) {{
+                printf("%7s", "n/a");
+            }} else if (!mix_resolved(contention[i][j])) {{
+                printf("%7s", "?");
+            }} else {{
+                printf("%6.0f%%", mix_clamp(contention[i][j]) * 100.0);
+            }}
+        }}
+        printf("\\n");
+    }}
+
+    printf("\\nLikely shared ports (contention >= %.0f%%):\\n", MIX_SHARED * 100.0);
+    for (int i = 0; i < MIX_SINGLES; i++) {{
+        for (int j = i + 1; j < MIX_SINGLES; j++) {{
+            if (contention[i][j] >= MIX_SHARED && mix_resolved(contention[i][j])) {{
+                printf("  %-6s + %-6s %4.0f%%\\n", mixes[i].label, mixes[j].label,
+                       mix_clamp(contention[i][j]) * 100.0);
+                shared++;
+            }}
+        }}
+    }}
+    if (!shared) {{
+        printf("  none\\n");
+    }}
+}}
+
+void run_mixes(void) {{
+    bench_cpu_t cpu;
+    bench_stats_t baseline;
+    char isa[96];
+    int pairs = 0;
+
+    bench_cpu_detect(&cpu);
+    printf("\\nInstruction mixes: %d copies x %d iterations per sample\\n", MIX_UNROLL, MIX_ITERATIONS);
+    bench_cpu_describe(&cpu);
+
+    // 빈 본문 조합 커널로 루프 카운터 오버헤드를 잰다 (조합 1회분당)
+    sample_arg_t baseline_sample = {{ test_mix_{MIX_BASELINE}, (double)MIX_ITERATIONS * MIX_UNROLL }};
+    measure(&baseline_sample, &baseline);
+    printf("Mix baseline (loop overhead): %.3f cycles/mix\\n", baseline.median);
+    printf("================================\\n");
+
+    for (int i = 0; i < MIX_COUNT; i++) {{
+        mix_case_t *mix = &mixes[i];
+
+        printf("Testing mix %s... ", mix->label);
+        if (!bench_cpu_has(&cpu, mix->isa)) {{
+            mix->skipped = 1;
+            printf("skipped (needs %s)\\n",
+                   bench_isa_format(bench_cpu_missing(&cpu, mix->isa), isa, sizeof(isa)));
+            continue;
+        }}
+        fflush(stdout);
+
+        sample_arg_t sample = {{ mix->func, (double)MIX_ITERATIONS * MIX_UNROLL }};
+        measure(&sample, &mix->stats);
+        mix->cycles = mix->stats.median - baseline.median;
+        pairs += mix->pair;
+        printf("%.3f cycles/mix (median of %d, CI %.2f%%)\\n",
+               mix->cycles, mix->stats.samples, mix->stats.ci_percent);
+    }}
+
+    printf("\\nNet cycles per mix: measured vs. predicted from the single-instruction rows\\n");
+    printf("%-28s %9s %9s %9s %7s %11s\\n", "Mix", "Measured", "Sum", "Max", "Ratio", "Contention");
+    for (int i = 0; i < MIX_COUNT; i++) {{
+        const mix_case_t *mix = &mixes[i];
+        double sum, max, contention = mix_contention(mix);
+
+        if (mix->skipped) {{
+            printf("%-28s %9s\\n", mix->label, "skipped");
+        }} else if (!mix_predict(mix, &sum, &max)) {{
+            printf("%-28s %9.3f %9s %9s %7s %11s\\n", mix->label, mix->cycles, "n/a", "n/a", "n/a", "n/a");
+        }} else if (isnan(contention)) {{
+            printf("%-28s %9.3f %9.3f %9.3f %7.2f %11s\\n",
+                   mix->label, mix->cycles, sum, max, mix->cycles / sum, "-");
+        }} else if (!mix_resolved(contention)) {{
+            printf("%-28s %9.3f %9.3f %9.3f %7.2f %11s\\n",
+                   mix->label, mix->cycles, sum, max, mix->cycles / sum, "unresolved");
+        }} else {{
+            printf("%-28s %9.3f %9.3f %9.3f %7.2f %10.0f%%\\n",
+                   mix->label, mix->cycles, sum, max, mix->cycles / sum, mix_clamp(contention) * 100.0);
+        }}
+    }}
+
+    if (pairs) {{
+        print_mix_matrix();
+    }}
+}}
+'''
+
     def create_c_driver(self):
         """C 드라이버 코드 생성"""
         c_code = '''#include <stdio.h>
 #include <time.h>
 #include <stdint.h>
 #include <string.h>
-
+#include "bench_stats.h"
+#include "bench_timer.h"
+''' + ('#include "bench_cpu.h"\n' if self.mixes else "") + '''
 // 어셈블리 함수 선언
 '''
 
-        instructions = ["add", "sub", "mul", "imul", "div", "mov", "cmp", "and", "or", "xor", "shl", "shr", "lea",
-                        "memory_load", "memory_store"]
+        instructions = list(self.INSTRUCTION_TESTS)
 
+        c_code += f"extern void test_{BASELINE_TEST}();\n"
         for instr in instructions:
             c_code += f"extern void test_{instr}();\n"
+        if self.mixes:
+            c_code += f"extern void test_mix_{MIX_BASELINE}();\n"
+        for index in range(len(self.mixes)):
+            c_code += f"extern void test_mix_{index}();\n"
 
         c_code += f'''
 #define ITERATIONS {self.iterations}
+#define UNROLL {self.unroll}
+
+// 샘플은 보정 없이 측정하고 순 사이클은 median(raw) - median(baseline)으로 구한다.
+// 샘플마다 빼면 작은 순값 대비 CI가 커져 수렴하지 않는다. 루프 오버헤드는 본문과
+// 병렬로 실행되므로 짧은 본문은 그 아래에 숨는다. 반복당 순 사이클이 기준선 잡음
+// max(MADS x MAD, FRACTION x 중앙값)보다 작으면 음수/0 대신 "hidden"으로 표시하고,
+// 보정 전 값을 상한으로 보여 준다.
+#define BASELINE_NOISE_MADS 3.0
+#define BASELINE_NOISE_FRACTION 0.05
 
 typedef struct {{
     const char* name;
     void (*func)();
+    int ops;                    // 본문 1회분의 명령어 수
+    bench_stats_t stats;        // 보정 전 cycles/instruction
+    bench_clock_kind_t clock;
+    double net;                 // median(raw) - median(baseline), cycles/instruction
+    int hidden;                 // 기준선 잡음보다 작아 측정할 수 없음
+    double upper_bound;         // hidden일 때 보정 전 cycles/instruction
 }} test_case_t;
 
-static inline uint64_t rdtsc() {{
-    uint32_t low, high;
-    __asm__ volatile ("rdtsc" : "=a" (low), "=d" (high));
-    return ((uint64_t)high << 32) | low;
-}}
+// 샘플 측정 인자: 함수, 샘플당 명령어 수
+typedef struct {{
+    void (*func)();
+    double ops;
+}} sample_arg_t;
+
+static bench_sampling_config_t sampling = {{ 1.0, 2.0, 5, 200, 5.0 }};
+static bench_timer_t timer;
+static int force_tsc = 0;
 
 void flush_cache() {{
     // 캐시 플러시를 위한 더미 작업
@@ -225,55 +682,140 @@ void flush_cache() {{
     }}
 }}
 
-int main() {{
+// 샘플 1개: 함수 1회 실행의 사이클 / 명령어 수 (루프 오버헤드 포함)
+double sample_test(void *arg) {{
+    sample_arg_t *sample = arg;
+
+    uint64_t start = bench_timer_start(&timer);
+    sample->func();
+    uint64_t end = bench_timer_stop(&timer);
+
+    return (double)(end - start) / sample->ops;
+}}
+
+// 캐시 플러시와 웜업 후 수렴할 때까지 반복 샘플링
+void measure(sample_arg_t *sample, bench_stats_t *stats) {{
+    flush_cache();
+    sample->func();
+    bench_sample(&sampling, sample_test, sample, stats);
+}}
+'''
+        if self.mixes:
+            c_code += self.create_mix_driver()
+
+        c_code += f'''
+int parse_options(int argc, char **argv) {{
+    static const struct option options[] = {{
+        BENCH_SAMPLING_LONG_OPTIONS,
+        {{ "tsc", no_argument, NULL, 't' }},
+        {{ NULL, 0, NULL, 0 }}
+    }};
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {{
+        if (opt == 't') {{
+            force_tsc = 1;
+        }} else if (!bench_sampling_handle_option(&sampling, opt, optarg)) {{
+            printf("Usage: %s [options]\\n", argv[0]);
+            bench_sampling_print_usage(&sampling);
+            printf("  --tsc               use serialized rdtscp instead of perf core-cycle counters\\n");
+            return 0;
+        }}
+    }}
+    return bench_sampling_validate(&sampling);
+}}
+
+int main(int argc, char **argv) {{
     test_case_t tests[] = {{
 '''
 
         for instr in instructions:
-            c_code += f'        {{"{instr}", test_{instr}}},\n'
+            c_code += f'        {{"{instr}", test_{instr}, {self.INSTRUCTION_TESTS[instr]["ops"]}}},\n'
 
-        c_code += '''    };
+        c_code += f'''    }};
 
     int num_tests = sizeof(tests) / sizeof(tests[0]);
 
+    if (!parse_options(argc, argv)) {{
+        return 1;
+    }}
+
+    bench_timer_init(&timer, force_tsc);
+
     printf("Assembly Instruction Benchmark\\n");
-    printf("Iterations per test: %d\\n", ITERATIONS);
+    printf("Iterations per test: %d (unroll x%d)\\n", ITERATIONS, UNROLL);
+    bench_timer_describe(&timer);
+    printf("Sampling: %d-%d samples, CI target %.2f%%, budget %.2fs\\n",
+           sampling.min_samples, sampling.max_samples, sampling.ci_percent, sampling.time_budget_s);
     printf("================================\\n");
 
-    for(int i = 0; i < num_tests; i++) {
-        printf("Testing %s... ", tests[i].name);
-        fflush(stdout);
-
-        // 캐시 플러시
-        flush_cache();
+    // 빈 본문 커널로 루프 오버헤드(인덱스 로드, 마스크, 카운터, 분기)를 보정
+    // 반복 샘플의 중앙값을 기준선으로 사용
+    bench_stats_t baseline;
+    sample_arg_t baseline_sample = {{ test_{BASELINE_TEST}, ITERATIONS }};
+    measure(&baseline_sample, &baseline);
+    double baseline_cycles = baseline.median * ITERATIONS;
+    double noise = fmax(BASELINE_NOISE_MADS * baseline.mad, BASELINE_NOISE_FRACTION * baseline.median);
+    printf("Baseline (loop overhead): %.0f cycles (%.2f cycles/iter, noise %.2f cycles/iter)\\n",
+           baseline_cycles, baseline.median, noise);
+    printf("================================\\n");
 
-        // 웜업
-        tests[i].func();
+    for(int i = 0; i < num_tests; i++) {{
+        double per_iteration = (double)tests[i].ops * UNROLL;
 
-        // 실제 측정
-        uint64_t start = rdtsc();
-        tests[i].func();
-        uint64_t end = rdtsc();
+        printf("Testing %s... ", tests[i].name);
+        fflush(stdout);
 
-        uint64_t cycles = end - start;
-        double cycles_per_op = (double)cycles / ITERATIONS;
+        sample_arg_t sample = {{ tests[i].func, ITERATIONS * per_iteration }};
+        measure(&sample, &tests[i].stats);
+        tests[i].clock = timer.kind;
+        tests[i].net = tests[i].stats.median - baseline.median / per_iteration;
+
+        if (tests[i].net * per_iteration < noise) {{
+            tests[i].hidden = 1;
+            tests[i].upper_bound = tests[i].stats.median;
+            printf("hidden by loop overhead: <= %.2f cycles/instruction (try a larger --unroll, %s)\\n",
+                   tests[i].upper_bound, bench_clock_name(tests[i].clock));
+            continue;
+        }}
+        printf("%.2f cycles/instruction (%d per copy, median of %d, CI %.2f%%, %s)\\n",
+               tests[i].net, tests[i].ops, tests[i].stats.samples, tests[i].stats.ci_percent,
+               bench_clock_name(tests[i].clock));
+    }}
 
-        printf("%lu cycles (%.2f cycles/op)\\n", cycles, cycles_per_op);
-    }
+    printf("\\nRaw cycles/instruction statistics, loop overhead included (* = CI target not reached):\\n");
+    bench_stats_print_header("Test");
+    for(int i = 0; i < num_tests; i++) {{
+        bench_stats_print_row(tests[i].name, &tests[i].stats);
+    }}
 
+    printf("\\nNet cycles/instruction = median(raw) - median(baseline) / instructions per iteration:\\n");
+    for(int i = 0; i < num_tests; i++) {{
+        if (tests[i].hidden) {{
+            printf("%-32s %10s (<= %.3f raw)\\n", tests[i].name, "[hidden]", tests[i].upper_bound);
+        }} else {{
+            printf("%-32s %10.3f\\n", tests[i].name, tests[i].net);
+        }}
+    }}
+{"""
+    run_mixes();
+""" if self.mixes else ""}
+    bench_timer_close(&timer);
     return 0;
-}'''
+}}'''
         return c_code
 
     def create_makefile(self):
         """Makefile 생성"""
         makefile = '''CC = gcc
 AS = as
-CFLAGS = -O2 -march=native
+CFLAGS = -O2 -Iasm_test
 ASFLAGS = -64
+LIBS = -lm
 
 TARGET = benchmark
 ASM_SRC = benchmark.s
+DATA_BLOB = benchmark_data.bin
 C_SRC = main.c
 ASM_OBJ = benchmark.o
 C_OBJ = main.o
@@ -281,12 +823,12 @@ C_OBJ = main.o
 all: $(TARGET)
 
 $(TARGET): $(ASM_OBJ) $(C_OBJ)
-	$(CC) $(ASM_OBJ) $(C_OBJ) -o $(TARGET)
+	$(CC) $(ASM_OBJ) $(C_OBJ) -o $(TARGET) $(LIBS)
 
-$(ASM_OBJ): $(ASM_SRC)
+$(ASM_OBJ): $(ASM_SRC) $(DATA_BLOB)
 	$(AS) $(ASFLAGS) $(ASM_SRC) -o $(ASM_OBJ)
 
-$(C_OBJ): $(C_SRC)
+$(C_OBJ): $(C_SRC) asm_test/bench_stats.h asm_test/bench_timer.h asm_test/bench_cpu.h
 	$(CC) $(CFLAGS) -c $(C_SRC) -o $(C_OBJ)
 
 clean:
@@ -298,19 +840,19 @@ test-fast: $(TARGET)
 
 # 중간 테스트 (50M iterations)
 test-medium:
-	python3 asm_benchmark_generator.py 50000000
+	python3 asm_test_maker.py 50000000
 	make clean && make
 	./$(TARGET)
 
 # 긴 테스트 (200M iterations, 1초+ 보장)
 test-long:
-	python3 asm_benchmark_generator.py 200000000
+	python3 asm_test_maker.py 200000000
 	make clean && make
 	./$(TARGET)
 
 # 매우 긴 테스트 (500M iterations)
 test-very-long:
-	python3 asm_benchmark_generator.py 500000000
+	python3 asm_test_maker.py 500000000
 	make clean && make
 	./$(TARGET)
 
@@ -358,7 +900,9 @@ help:
 	@echo "  make check-power-tools # 전력 도구 설치 상태 확인"
 	@echo ""
 	@echo "=== 수동 설정 ==="
-	@echo "  python3 asm_benchmark_generator.py [ITERATIONS]"
+	@echo "  python3 asm_test_maker.py [ITERATIONS] [--unroll 1|4|16|64]"
+	@echo "  python3 asm_test_maker.py [ITERATIONS] --mix 'imul:2, popcnt:1, add:3'  # 명령어 조합"
+	@echo "  python3 asm_test_maker.py [ITERATIONS] --pairwise  # 모든 쌍의 포트 경합 행렬"
 	@echo "  make clean && make && ./benchmark"
 	@echo ""
 	@echo "=== 예시 ==="
@@ -373,8 +917,9 @@ help:
         """전체 벤치마크 시스템 생성"""
         print("Generating assembly instruction benchmark...")
 
-        # 랜덤 데이터 생성
-        self.generate_random_data()
+        # 랜덤 데이터 바이너리 생성
+        with open(DATA_BLOB, "wb") as f:
+            f.write(self.generate_data_blob())
 
         # 어셈블리 파일 생성
         print("Creating assembly file...")
@@ -416,23 +961,39 @@ help:
 
 
 if __name__ == "__main__":
-    import sys
+    import argparse
+
+    parser = argparse.ArgumentParser(description="어셈블리 명령어 벤치마크 생성기")
+    parser.add_argument("iterations", nargs="?", type=int,
+                        help="테스트당 반복 횟수 (기본값: 10M)")
+    parser.add_argument("--unroll", type=int, default=16, choices=SUPPORTED_UNROLL,
+                        help="반복당 본문 복제 횟수 (기본값: 16)")
+    parser.add_argument("--mix", action="append", default=[], metavar="SPEC",
+                        help="명령어 조합 (예: \"imul:2, popcnt:1, add:3\", 여러 번 지정 가능). "
+                             f"사용 가능: {', '.join(AssemblyBenchmarkGenerator.MIX_INSTRUCTIONS)}")
+    parser.add_argument("--pairwise", action="store_true",
+                        help="등록된 조합 명령어의 모든 1:1 쌍을 재고 포트 경합 행렬 출력")
+    args = parser.parse_args()
 
     # Ryzen 5 5600에 최적화된 설정
-    DATA_SIZE = 100000  # L3 캐시(32MB)보다 큰 데이터셋
+    DATA_SIZE = 100000  # 2의 거듭제곱으로 올림 (131072 x 8B = 1MB)
 
     # 명령행 인수로 iteration 수 조정 가능
-    if len(sys.argv) > 1:
-        ITERATIONS = int(sys.argv[1])
+    if args.iterations is not None:
+        ITERATIONS = args.iterations
         print(f"Using {ITERATIONS:,} iterations from command line")
     else:
         # 기본값: 빠른 테스트로 시작
         ITERATIONS = 10000000  # 10M iterations (약 0.1-0.5초 예상)
         print(f"Using default {ITERATIONS:,} iterations")
         print("실행 후 시간이 너무 짧으면 다음과 같이 늘려보세요:")
-        print("  python3 asm_benchmark_generator.py 50000000   # 50M")
-        print("  python3 asm_benchmark_generator.py 100000000  # 100M")
-        print("  python3 asm_benchmark_generator.py 200000000  # 200M")
-
-    generator = AssemblyBenchmarkGenerator(DATA_SIZE, ITERATIONS)
-    generator.generate_benchmark()
\ No newline at end of file
+        print("  python3 asm_test_maker.py 50000000   # 50M")
+        print("  python3 asm_test_maker.py 100000000  # 100M")
+        print("  python3 asm_test_maker.py 200000000  # 200M")
+    print(f"Unroll factor: x{args.unroll}")
+
+    try:
+        generator = AssemblyBenchmarkGenerator(DATA_SIZE, ITERATIONS, args.unroll, args.mix, args.pairwise)
+    except ValueError as error:
+        parser.error(str(error))
+    generator.generate_benchmark()
@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+"""스윕 결과 CSV에 Big-O 모델을 최소제곱으로 맞추는 모듈
+
+linear.csv, const.csv 처럼 save_benchmark_to_csv(또는 native/complexity.hpp)가
+저장한 "n,<이름>,..." 형식의 CSV를 읽어, 열마다 t = a + b*f(n) 형태의 모델
+O(1), O(log n), O(n), O(n log n), O(n^2), O(n^3), O(2^n)을 맞추고
+BIC와 잔차 검사로 가장 알맞은 모델을 고른다.
+
+선택 규칙:
+  1. 기울기 b가 양수이고 유의하지 않은(t < MIN_SLOPE_T) 성장 모델은 버린다.
+     남는 모델이 없으면 O(1).
+  2. 잔차 부호의 런 검정(runs test)에서 체계적으로 어긋나는(z < -RUNS_Z_LIMIT)
+     모델은 부적합으로 본다. 시간 크기 대비 RESIDUAL_EPSILON 이하의 잔차는 0으로
+     보므로 정확히 맞는 모델은 항상 통과한다.
+  3. 적합한 모델 중 최소 BIC(= n ln(SSR/n) + k ln n)와의 차이가 BIC_TOLERANCE 이내인
+     것 중 가장 단순한 모델. 성장 모델끼리는 모수 수가 같아서 BIC 차이는 SSR 비율의
+     로그이고, R² 차이처럼 측정 범위의 분산에 묻히지 않는다 (O(n) vs O(n log n)).
+
+명령행:
+  python3 complexity_fit.py linear.csv square-test.csv
+  python3 complexity_fit.py results.csv --max "O(n)"        # 초과하면 종료 코드 1
+  python3 complexity_fit.py results.csv --expect "sort=O(n log n)"
+"""
+import csv
+import math
+import sys
+
+# (키, 표시 이름, f(n)) - 단순한 순서. None은 상수 모델
+MODELS = [
+    ("const", "O(1)", None),
+    ("log", "O(log n)", lambda n: math.log2(n)),
+    ("linear", "O(n)", lambda n: n),
+    ("nlogn", "O(n log n)", lambda n: n * math.log2(n)),
+    ("quadratic", "O(n^2)", lambda n: n ** 2),
+    ("cubic", "O(n^3)", lambda n: n ** 3),
+    ("exponential", "O(2^n)", lambda n: 2.0 ** n),
+]
+
+MODEL_RANK = {name: rank for rank, (_, name, _) in enumerate(MODELS)}
+
+# 명령행에서 받는 모델 이름 별칭
+MODEL_ALIASES = {
+    "1": "O(1)", "const": "O(1)",
+    "logn": "O(log n)", "log": "O(log n)",
+    "n": "O(n)", "linear": "O(n)",
+    "nlogn": "O(n log n)",
+    "n^2": "O(n^2)", "n2": "O(n^2)", "quadratic": "O(n^2)",
+    "n^3": "O(n^3)", "n3": "O(n^3)", "cubic": "O(n^3)",
+    "2^n": "O(2^n)", "exp": "O(2^n)", "exponential": "O(2^n)",
+}
+
+MIN_SLOPE_T = 3.0       # 성장 모델 기울기의 최소 t 통계량
+RUNS_Z_LIMIT = 3.0      # 잔차 런 검정 z가 -RUNS_Z_LIMIT보다 작으면 체계적 오차
+BIC_TOLERANCE = 6.0     # 최소 BIC보다 이만큼 크지 않은 단순 모델은 허용 ("강한 증거" 기준)
+RESIDUAL_EPSILON = 1e-9 # 최대 |t| 대비 이보다 작은 잔차는 반올림 오차로 본다
+MAX_MODEL_VALUE = 1e150 # f(n)이 이보다 크면 해당 모델은 적합하지 않음
+
+
+class FitResult:
+    """한 모델의 적합 결과: t ≈ a + b * f(n)"""
+
+    def __init__(self, name, a, b, r2, slope_t, runs_z, bic):
+        self.name = name
+        self.a = a
+        self.b = b
+        self.r2 = r2
+        self.slope_t = slope_t
+        self.runs_z = runs_z
+        self.bic = bic
+
+    @property
+    def significant(self):
+        return self.name == "O(1)" or (self.b > 0 and self.slope_t >= MIN_SLOPE_T)
+
+    @property
+    def residuals_ok(self):
+        return self.runs_z >= -RUNS_Z_LIMIT
+
+    def __repr__(self):
+        return (f"FitResult({self.name}, a={self.a:.4g}, b={self.b:.4g}, "
+                f"r2={self.r2:.4f}, t={self.slope_t:.1f}, runs_z={self.runs_z:.1f}, bic={self.bic:.1f})")
+
+
+def normalize_model(name):
+    """'n^2', 'O(n^2)', 'nlogn' 등을 표시 이름으로 변환"""
+    key = name.strip()
+    if key in MODEL_RANK:
+        return key
+    compact = key.replace(" ", "").lower()
+    if compact.startswith("o(") and compact.endswith(")"):
+        compact = compact[2:-1]
+    if compact in MODEL_ALIASES:
+        return MODEL_ALIASES[compact]
+    raise ValueError(f"unknown model: {name}")
+
+
+def runs_z_score(residuals, tolerance=0.0):
+    """잔차 부호 런 검정 z 값. 기대보다 런이 적으면(체계적 곡률) 음수로 커진다.
+    |잔차| <= tolerance는 부호가 없는 것으로 보고 뺀다."""
+    signs = [r > 0 for r in residuals if abs(r) > tolerance]
+    n_pos = sum(signs)
+    n_neg = len(signs) - n_pos
+    if n_pos == 0 or n_neg == 0:
+        return 0.0 if len(signs) < 2 else -math.inf
+    runs = 1 + sum(1 for i in range(1, len(signs)) if signs[i] != signs[i - 1])
+    total = n_pos + n_neg
+    expected = 2.0 * n_pos * n_neg / total + 1
+    variance = (expected - 1) * (expected - 2) / (total - 1)
+    if variance <= 0:
+        return 0.0
+    return (runs - expected) / math.sqrt(variance)
+
+
+def bic_score(ss_res, count, params, tolerance):
+    """가우스 잔차 가정의 BIC. 정확히 맞는 경우 log(0)을 피하도록 SSR에 하한을 둔다."""
+    ss_res = max(ss_res, tolerance * tolerance * count, sys.float_info.min)
+    return count * math.log(ss_res / count) + params * math.log(count)
+
+
+def fit_model(ns, ts, name, f):
+    """단일 모델 최소제곱 적합. f(n)을 계산할 수 없으면(오버플로) None"""
+    count = len(ts)
+    mean_t = sum(ts) / count
+    ss_tot = sum((t - mean_t) ** 2 for t in ts)
+    tolerance = RESIDUAL_EPSILON * max(abs(t) for t in ts)
+
+    if f is None:
+        residuals = [t - mean_t for t in ts]
+        return FitResult(name, mean_t, 0.0, 0.0, 0.0, runs_z_score(residuals, tolerance),
+                         bic_score(ss_tot, count, 1, tolerance))
+
+    try:
+        xs = [float(f(max(n, 1))) for n in ns]
+    except OverflowError:
+        return None
+    if max(xs) > MAX_MODEL_VALUE:
+        return None     # 제곱합이 오버플로하는 범위 (큰 n의 2^n)
+
+    mean_x = sum(xs) / count
+    sxx = sum((x - mean_x) ** 2 for x in xs)
+    if sxx == 0:
+        return None
+    sxy = sum((x - mean_x) * (t - mean_t) for x, t in zip(xs, ts))
+    b = sxy / sxx
+    a = mean_t - b * mean_x
+
+    residuals = [t - (a + b * x) for x, t in zip(xs, ts)]
+    ss_res = sum(r * r for r in residuals)
+    r2 = 1.0 - ss_res / ss_tot if ss_tot > 0 else 0.0
+
+    # 기울기 표준오차로 t 통계량 계산
+    if count > 2 and ss_res > tolerance * tolerance * count:
+        slope_se = math.sqrt(ss_res / (count - 2) / sxx)
+        slope_t = b / slope_se
+    else:
+        slope_t = math.inf if b > 0 else 0.0
+
+    return FitResult(name, a, b, r2, slope_t, runs_z_score(residuals, tolerance),
+                     bic_score(ss_res, count, 2, tolerance))
+
+
+def fit_column(ns, ts):
+    """모든 모델을 적합해 MODELS 순서의 FitResult 목록을 반환"""
+    if len(ns) != len(ts) or len(ts) < 3:
+        raise ValueError("need at least 3 (n, time) points")
+    fits = []
+    for _, name, f in MODELS:
+        fit = fit_model(ns, ts, name, f)
+        if fit is not None:
+            fits.append(fit)
+    return fits
+
+
+def best_fit(fits):
+    """선택 규칙에 따라 가장 알맞은 모델을 고른다"""
+    candidates = [fit for fit in fits if fit.significant]
+    growth = [fit for fit in candidates if fit.name != "O(1)"]
+    if not growth:
+        return next(fit for fit in fits if fit.name == "O(1)")
+
+    adequate = [fit for fit in growth if fit.residuals_ok] or growth
+    best_bic = min(fit.bic for fit in adequate)
+    for fit in adequate:
+        if fit.bic <= best_bic + BIC_TOLERANCE:
+            return fit
+    return adequate[0]
+
+
+def read_sweep_csv(filename, skip=0):
+    """'n,<이름>,...' CSV(또는 .ttr 결과 파일)를 읽어 (n 목록, {이름: 시간 목록})을 반환.
+    앞의 skip행은 버린다."""
+    if filename.endswith(".ttr"):
+        from resultfile import ResultFile
+        with ResultFile(filename) as result:
+            points, sweep = result.sweep()
+        ns = [float(n) for n in points[skip:]]
+        columns = {}
+        for j, (name, times) in enumerate(sweep, start=1):
+            key = name if name not in columns else f"{name}#{j}"
+            columns[key] = times[skip:]
+        return ns, columns
+
+    with open(filename, newline="", encoding="utf-8") as csvfile:
+        reader = csv.reader(csvfile)
+        header = next(reader)
+        rows = [row for row in reader if row]
+
+    rows = rows[skip:]
+    ns = [float(row[0]) for row in rows]
+    columns = {}
+    for j, name in enumerate(header[1:], start=1):
+        # 같은 이름의 열이 있으면 (예: linear.csv의 "n") 위치로 구분
+        key = name if name not in columns else f"{name}#{j}"
+        columns[key] = [float(row[j]) for row in rows]
+    return ns, columns
+
+
+def fit_csv(filename, skip=0):
+    """CSV의 모든 열을 적합해 {열 이름: (최적 FitResult, 전체 목록)}을 반환"""
+    ns, columns = read_sweep_csv(filename, skip)
+    report = {}
+    for name, ts in columns.items():
+        fits = fit_column(ns, ts)
+        report[name] = (best_fit(fits), fits)
+    return report
+
+
+def print_report(filename, report):
+    print(f"{filename}:")
+    print("%-16s %-11s %8s %12s %12s %8s  %s" %
+          ("Column", "Best", "R²", "a (s)", "b (s/f(n))", "Runs z", "Runner-up"))
+    for name, (best, fits) in report.items():
+        others = sorted((fit for fit in fits if fit is not best and fit.significant),
+                        key=lambda fit: fit.bic)
+        runner_up = f"{others[0].name} ΔBIC={others[0].bic - best.bic:+.1f}" if others else "-"
+        print("%-16s %-11s %8.4f %12.4g %12.4g %8.1f  %s" %
+              (name, best.name, best.r2, best.a, best.b, best.runs_z, runner_up))
+    print()
+
+
+def main(argv):
+    import argparse
+
+    parser = argparse.ArgumentParser(description="스윕 결과 CSV의 Big-O 모델 적합")
+    parser.add_argument("files", nargs="+", help="'n,<이름>,...' 형식의 CSV 파일")
+    parser.add_argument("--skip", type=int, default=0, help="앞에서 버릴 행 수 (웜업 제거)")
+    parser.add_argument("--max", dest="max_model",
+                        help="모든 열에 허용하는 최대 모델 (예: 'O(n)'), 초과하면 종료 코드 1")
+    parser.add_argument("--expect", action="append", default=[], metavar="COLUMN=MODEL",
+                        help="열별 허용 최대 모델 (여러 번 지정 가능)")
+    args = parser.parse_args(argv)
+
+    limits = {}
+    for item in args.expect:
+        column, _, model = item.partition("=")
+        limits[column.strip()] = normalize_model(model)
+    max_model = normalize_model(args.max_model) if args.max_model else None
+
+    violations = []
+    for filename in args.files:
+        report = fit_csv(filename, args.skip)
+        print_report(filename, report)
+        for name, (best, _) in report.items():
+            limit = limits.get(name, max_model)
+            if limit and MODEL_RANK[best.name] > MODEL_RANK[limit]:
+                violations.append(f"{filename}: {name} is {best.name}, expected at most {limit}")
+
+    for violation in violations:
+        print("REGRESSION: " + violation)
+    return 1 if violations else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -2,8 +2,11 @@
 #include <time.h>
 #include <stdint.h>
 #include <string.h>
+#include "bench_stats.h"
+#include "bench_timer.h"
 
 // 어셈블리 함수 선언
+extern void test_baseline();
 extern void test_add();
 extern void test_sub();
 extern void test_mul();
@@ -21,17 +24,36 @@ extern void test_memory_load();
 extern void test_memory_store();
 
 #define ITERATIONS 10000000
+#define UNROLL 16
+
+// 샘플은 보정 없이 측정하고 순 사이클은 median(raw) - median(baseline)으로 구한다.
+// 샘플마다 빼면 작은 순값 대비 CI가 커져 수렴하지 않는다. 루프 오버헤드는 본문과
+// 병렬로 실행되므로 짧은 본문은 그 아래에 숨는다. 반복당 순 사이클이 기준선 잡음
+// max(MADS x MAD, FRACTION x 중앙값)보다 작으면 음수/0 대신 "hidden"으로 표시하고,
+// 보정 전 값을 상한으로 보여 준다.
+#define BASELINE_NOISE_MADS 3.0
+#define BASELINE_NOISE_FRACTION 0.05
 
 typedef struct {
     const char* name;
     void (*func)();
+    int ops;                    // 본문 1회분의 명령어 수
+    bench_stats_t stats;        // 보정 전 cycles/instruction
+    bench_clock_kind_t clock;
+    double net;                 // median(raw) - median(baseline), cycles/instruction
+    int hidden;                 // 기준선 잡음보다 작아 측정할 수 없음
+    double upper_bound;         // hidden일 때 보정 전 cycles/instruction
 } test_case_t;
 
-static inline uint64_t rdtsc() {
-    uint32_t low, high;
-    __asm__ volatile ("rdtsc" : "=a" (low), "=d" (high));
-    return ((uint64_t)high << 32) | low;
-}
+// 샘플 측정 인자: 함수, 샘플당 명령어 수
+typedef struct {
+    void (*func)();
+    double ops;
+} sample_arg_t;
+
+static bench_sampling_config_t sampling = { 1.0, 2.0, 5, 200, 5.0 };
+static bench_timer_t timer;
+static int force_tsc = 0;
 
 void flush_cache() {
     // 캐시 플러시를 위한 더미 작업
@@ -41,51 +63,128 @@ void flush_cache() {
     }
 }
 
-int main() {
+// 샘플 1개: 함수 1회 실행의 사이클 / 명령어 수 (루프 오버헤드 포함)
+double sample_test(void *arg) {
+    sample_arg_t *sample = arg;
+
+    uint64_t start = bench_timer_start(&timer);
+    sample->func();
+    uint64_t end = bench_timer_stop(&timer);
+
+    return (double)(end - start) / sample->ops;
+}
+
+// 캐시 플러시와 웜업 후 수렴할 때까지 반복 샘플링
+void measure(sample_arg_t *sample, bench_stats_t *stats) {
+    flush_cache();
+    sample->func();
+    bench_sample(&sampling, sample_test, sample, stats);
+}
+
+int parse_options(int argc, char **argv) {
+    static const struct option options[] = {
+        BENCH_SAMPLING_LONG_OPTIONS,
+        { "tsc", no_argument, NULL, 't' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        if (opt == 't') {
+            force_tsc = 1;
+        } else if (!bench_sampling_handle_option(&sampling, opt, optarg)) {
+            printf("Usage: %s [options]\n", argv[0]);
+            bench_sampling_print_usage(&sampling);
+            printf("  --tsc               use serialized rdtscp instead of perf core-cycle counters\n");
+            return 0;
+        }
+    }
+    return bench_sampling_validate(&sampling);
+}
+
+int main(int argc, char **argv) {
     test_case_t tests[] = {
-        {"add", test_add},
-        {"sub", test_sub},
-        {"mul", test_mul},
-        {"imul", test_imul},
-        {"div", test_div},
-        {"mov", test_mov},
-        {"cmp", test_cmp},
-        {"and", test_and},
-        {"or", test_or},
-        {"xor", test_xor},
-        {"shl", test_shl},
-        {"shr", test_shr},
-        {"lea", test_lea},
-        {"memory_load", test_memory_load},
-        {"memory_store", test_memory_store},
+        {"add", test_add, 2},
+        {"sub", test_sub, 2},
+        {"mul", test_mul, 1},
+        {"imul", test_imul, 1},
+        {"div", test_div, 2},
+        {"mov", test_mov, 3},
+        {"cmp", test_cmp, 2},
+        {"and", test_and, 2},
+        {"or", test_or, 2},
+        {"xor", test_xor, 2},
+        {"shl", test_shl, 2},
+        {"shr", test_shr, 2},
+        {"lea", test_lea, 2},
+        {"memory_load", test_memory_load, 1},
+        {"memory_store", test_memory_store, 2},
     };
 
     int num_tests = sizeof(tests) / sizeof(tests[0]);
 
+    if (!parse_options(argc, argv)) {
+        return 1;
+    }
+
+    bench_timer_init(&timer, force_tsc);
+
     printf("Assembly Instruction Benchmark\n");
-    printf("Iterations per test: %d\n", ITERATIONS);
+    printf("Iterations per test: %d (unroll x%d)\n", ITERATIONS, UNROLL);
+    bench_timer_describe(&timer);
+    printf("Sampling: %d-%d samples, CI target %.2f%%, budget %.2fs\n",
+           sampling.min_samples, sampling.max_samples, sampling.ci_percent, sampling.time_budget_s);
+    printf("================================\n");
+
+    // 빈 본문 커널로 루프 오버헤드(인덱스 로드, 마스크, 카운터, 분기)를 보정
+    // 반복 샘플의 중앙값을 기준선으로 사용
+    bench_stats_t baseline;
+    sample_arg_t baseline_sample = { test_baseline, ITERATIONS };
+    measure(&baseline_sample, &baseline);
+    double baseline_cycles = baseline.median * ITERATIONS;
+    double noise = fmax(BASELINE_NOISE_MADS * baseline.mad, BASELINE_NOISE_FRACTION * baseline.median);
+    printf("Baseline (loop overhead): %.0f cycles (%.2f cycles/iter, noise %.2f cycles/iter)\n",
+           baseline_cycles, baseline.median, noise);
     printf("================================\n");
 
     for(int i = 0; i < num_tests; i++) {
+        double per_iteration = (double)tests[i].ops * UNROLL;
+
         printf("Testing %s... ", tests[i].name);
         fflush(stdout);
 
-        // 캐시 플러시
-        flush_cache();
-
-        // 웜업
-        tests[i].func();
+        sample_arg_t sample = { tests[i].func, ITERATIONS * per_iteration };
+        measure(&sample, &tests[i].stats);
+        tests[i].clock = timer.kind;
+        tests[i].net = tests[i].stats.median - baseline.median / per_iteration;
 
-        // 실제 측정
-        uint64_t start = rdtsc();
-        tests[i].func();
-        uint64_t end = rdtsc();
+        if (tests[i].net * per_iteration < noise) {
+            tests[i].hidden = 1;
+            tests[i].upper_bound = tests[i].stats.median;
+            printf("hidden by loop overhead: <= %.2f cycles/instruction (try a larger --unroll, %s)\n",
+                   tests[i].upper_bound, bench_clock_name(tests[i].clock));
+            continue;
+        }
+        printf("%.2f cycles/instruction (%d per copy, median of %d, CI %.2f%%, %s)\n",
+               tests[i].net, tests[i].ops, tests[i].stats.samples, tests[i].stats.ci_percent,
+               bench_clock_name(tests[i].clock));
+    }
 
-        uint64_t cycles = end - start;
-        double cycles_per_op = (double)cycles / ITERATIONS;
+    printf("\nRaw cycles/instruction statistics, loop overhead included (* = CI target not reached):\n");
+    bench_stats_print_header("Test");
+    for(int i = 0; i < num_tests; i++) {
+        bench_stats_print_row(tests[i].name, &tests[i].stats);
+    }
 
-        printf("%lu cycles (%.2f cycles/op)\n", cycles, cycles_per_op);
+    printf("\nNet cycles/instruction = median(raw) - median(baseline) / instructions per iteration:\n");
+    for(int i = 0; i < num_tests; i++) {
+        if (tests[i].hidden) {
+            printf("%-32s %10s (<= %.3f raw)\n", tests[i].name, "[hidden]", tests[i].upper_bound);
+        } else {
+            printf("%-32s %10.3f\n", tests[i].name, tests[i].net);
+        }
     }
 
+    bench_timer_close(&timer);
     return 0;
 }
\ No newline at end of file
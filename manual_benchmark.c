@@ -1,28 +1,27 @@
 #include <stdio.h>
 #include <time.h>
 #include <stdint.h>
+#include "asm_test/bench_timer.h"
 
 extern void test_add();
 
-static inline uint64_t rdtsc() {
-    uint32_t low, high;
-    __asm__ volatile ("rdtsc" : "=a" (low), "=d" (high));
-    return ((uint64_t)high << 32) | low;
-}
-
 int main() {
     printf("Manual Assembly Benchmark Test\n");
     printf("==============================\n");
     
+    bench_timer_t timer;
+    bench_timer_init(&timer, 0);
+    bench_timer_describe(&timer);
+    
     struct timespec start, end;
     
     // 측정
     clock_gettime(CLOCK_MONOTONIC, &start);
-    uint64_t start_cycles = rdtsc();
+    uint64_t start_cycles = bench_timer_start(&timer);
     
     test_add();
     
-    uint64_t end_cycles = rdtsc();
+    uint64_t end_cycles = bench_timer_stop(&timer);
     clock_gettime(CLOCK_MONOTONIC, &end);
     
     // 결과 계산
@@ -31,8 +30,9 @@ int main() {
     uint64_t cycles = end_cycles - start_cycles;
     
     printf("Time: %.3f seconds\n", time_taken);
-    printf("Cycles: %lu\n", cycles);
+    printf("Cycles: %lu (%s)\n", cycles, bench_clock_name(timer.kind));
     printf("Frequency: %.2f GHz\n", cycles / (time_taken * 1e9));
     
+    bench_timer_close(&timer);
     return 0;
 }
@@ -0,0 +1,245 @@
+// complexity.hpp - 네이티브 C++ 복잡도 측정 하네스 (헤더 전용)
+//
+// timetest.py의 time_test가 파이썬 문자열을 exec()하는 대신, C++ 호출 가능 객체와
+// 입력 생성기를 받아 n을 스윕하며 각 지점을 asm_test/bench_timer.h의 사이클
+// 클럭(perf rdpmc 또는 직렬화된 rdtsc)으로 측정한다. 결과 CSV는 linear.csv,
+// const.csv와 같은 형식이다: 헤더 "n,<이름>,..." 다음에 n별로 초 단위 값.
+//
+// 측정 구간에는 타이머 읽기와 호출 가능 객체 호출만 들어간다. 케이스는 함수 객체
+// 타입으로 특수화되므로 std::function이나 가상 호출이 없고, 입력 생성과 통계는
+// 모두 측정 구간 밖에서 이루어진다. 빈 호출의 타이머 오버헤드는 보정해 뺀다.
+//
+//   auto sort_case = complexity::make_case("sort",
+//       [](std::size_t n) { return random_vector(n); },          // 입력 생성 (측정 안 함)
+//       [](std::vector<int> &v) { std::sort(v.begin(), v.end()); });  // 측정 대상
+//   complexity::sweep_config config;
+//   config.n_max = 100000;
+//   complexity::run_to_csv("sort.csv", config, sort_case);
+
+#ifndef NATIVE_COMPLEXITY_HPP
+#define NATIVE_COMPLEXITY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../asm_test/bench_timer.h"
+
+namespace complexity {
+
+// 스윕 설정: n_min부터 n_max까지 선형(n_step) 또는 기하(factor) 증가
+struct sweep_config {
+    std::size_t n_min = 1;
+    std::size_t n_max = 1000;
+    std::size_t n_step = 1;         // 선형 스윕 간격
+    bool geometric = false;         // true면 n *= factor
+    double factor = 2.0;
+    int repeats = 5;                // 지점당 반복 횟수 (중앙값 사용)
+    bool force_tsc = false;         // perf 카운터 대신 TSC 사용
+    bool progress = true;           // stderr에 진행 상황 출력
+};
+
+// 측정 결과를 컴파일러가 제거하지 못하게 한다
+template <class T>
+inline void do_not_optimize(T const &value) {
+    __asm__ volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() {
+    __asm__ volatile("" : : : "memory");
+}
+
+// 이름 + 입력 생성기 + 측정 대상. Gen: size_t -> Input, Fn: Input& -> 아무 값
+template <class Gen, class Fn>
+struct bench_case {
+    std::string name;
+    Gen generate;
+    Fn fn;
+};
+
+template <class Gen, class Fn>
+bench_case<Gen, Fn> make_case(std::string name, Gen generate, Fn fn) {
+    return bench_case<Gen, Fn>{std::move(name), std::move(generate), std::move(fn)};
+}
+
+// 사이클 클럭 + 초 단위 환산 비율 + 빈 측정 오버헤드
+class cycle_clock {
+public:
+    explicit cycle_clock(bool force_tsc) {
+        bench_timer_init(&timer_, force_tsc ? 1 : 0);
+        calibrate();
+    }
+    ~cycle_clock() { bench_timer_close(&timer_); }
+    cycle_clock(const cycle_clock &) = delete;
+    cycle_clock &operator=(const cycle_clock &) = delete;
+
+    // fn(input)만 측정 구간에 넣는다. 케이스 타입별로 인스턴스화되어 인라인된다.
+    template <class Fn, class Input>
+    double measure_cycles(Fn &fn, Input &input) const {
+        using result_t = decltype(fn(input));
+        uint64_t start, end;
+
+        clobber_memory();
+        start = bench_timer_start(&timer_);
+        if constexpr (std::is_void_v<result_t>) {
+            fn(input);
+            end = bench_timer_stop(&timer_);
+        } else {
+            result_t result = fn(input);
+            end = bench_timer_stop(&timer_);
+            do_not_optimize(result);
+        }
+        clobber_memory();
+        return (double)(end - start) - overhead_cycles_;
+    }
+
+    double seconds(double cycles) const { return cycles > 0.0 ? cycles / cycles_per_second_ : 0.0; }
+    double cycles_per_second() const { return cycles_per_second_; }
+    double overhead_cycles() const { return overhead_cycles_; }
+    bench_clock_kind_t kind() const { return timer_.kind; }
+    void describe() const { bench_timer_describe(&timer_); }
+
+private:
+    static double now_seconds() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    // 빈 구간의 중앙값 = 오버헤드, 바쁜 대기 50ms 동안의 사이클/초 = 환산 비율
+    void calibrate() {
+        std::vector<double> empty(101);
+        for (double &sample : empty) {
+            uint64_t start = bench_timer_start(&timer_);
+            uint64_t end = bench_timer_stop(&timer_);
+            sample = (double)(end - start);
+        }
+        std::nth_element(empty.begin(), empty.begin() + empty.size() / 2, empty.end());
+        overhead_cycles_ = empty[empty.size() / 2];
+
+        double wall_start = now_seconds();
+        uint64_t start = bench_timer_start(&timer_);
+        while (now_seconds() - wall_start < 0.05) {
+        }
+        uint64_t end = bench_timer_stop(&timer_);
+        cycles_per_second_ = (double)(end - start) / (now_seconds() - wall_start);
+    }
+
+    bench_timer_t timer_;
+    double overhead_cycles_ = 0.0;
+    double cycles_per_second_ = 1.0;
+};
+
+// 스윕할 n 목록. 마지막 점이 n_max에 못 미치면 n_max를 덧붙여 끝점을 항상 잰다
+inline std::vector<std::size_t> sweep_points(const sweep_config &config) {
+    std::vector<std::size_t> points;
+    for (std::size_t n = config.n_min; n <= config.n_max;) {
+        points.push_back(n);
+        std::size_t next = config.geometric ? (std::size_t)(n * config.factor) : n + config.n_step;
+        n = next > n ? next : n + 1;
+    }
+    if (!points.empty() && points.back() < config.n_max) {
+        points.push_back(config.n_max);
+    }
+    return points;
+}
+
+// 한 케이스의 한 지점: repeats번 새 입력을 만들어 측정하고 중앙값(초)을 반환
+template <class Case>
+double measure_point(const cycle_clock &clock, Case &bench, std::size_t n, int repeats) {
+    std::vector<double> samples;
+    samples.reserve(repeats);
+    for (int r = 0; r < repeats; r++) {
+        auto input = bench.generate(n);
+        samples.push_back(clock.measure_cycles(bench.fn, input));
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return clock.seconds(samples[samples.size() / 2]);
+}
+
+// 결과 표: points[i]에 대한 케이스 j의 초 단위 시간은 seconds[j][i]
+struct sweep_result {
+    std::vector<std::string> names;
+    std::vector<std::size_t> points;
+    std::vector<std::vector<double>> seconds;
+};
+
+template <class... Cases>
+sweep_result run(const sweep_config &config, Cases &...cases) {
+    if (config.repeats < 1 || config.n_min > config.n_max) {
+        throw std::invalid_argument("complexity::run: invalid sweep_config");
+    }
+
+    cycle_clock clock(config.force_tsc);
+    sweep_result result;
+    result.points = sweep_points(config);
+    result.names = {cases.name...};
+    result.seconds.assign(sizeof...(Cases), std::vector<double>(result.points.size()));
+
+    if (config.progress) {
+        std::fprintf(stderr, "Cycle clock: %s (%.3f GHz, overhead %.0f cycles)\n",
+                     bench_clock_name(clock.kind()), clock.cycles_per_second() / 1e9,
+                     clock.overhead_cycles());
+    }
+
+    // 케이스별로 전체 스윕 (fold expression으로 케이스 타입마다 특수화)
+    std::size_t index = 0;
+    auto run_case = [&](auto &bench) {
+        for (std::size_t i = 0; i < result.points.size(); i++) {
+            if (config.progress) {
+                std::fprintf(stderr, "%s progress: %zu/%zu\r", bench.name.c_str(), i + 1,
+                             result.points.size());
+            }
+            result.seconds[index][i] = measure_point(clock, bench, result.points[i], config.repeats);
+        }
+        if (config.progress) {
+            std::fprintf(stderr, "\n");
+        }
+        index++;
+    };
+    (run_case(cases), ...);
+
+    return result;
+}
+
+// linear.csv 형식으로 저장: "n,<이름>,..." + n별 초 단위 값
+inline void write_csv(const std::string &path, const sweep_result &result) {
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        throw std::runtime_error("complexity::write_csv: cannot open " + path);
+    }
+
+    std::fprintf(file, "n");
+    for (const std::string &name : result.names) {
+        std::fprintf(file, ",%s", name.c_str());
+    }
+    std::fprintf(file, "\n");
+
+    for (std::size_t i = 0; i < result.points.size(); i++) {
+        std::fprintf(file, "%zu", result.points[i]);
+        for (const std::vector<double> &column : result.seconds) {
+            std::fprintf(file, ",%.17g", column[i]);   // double 왕복에 충분한 자릿수
+        }
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+}
+
+template <class... Cases>
+sweep_result run_to_csv(const std::string &path, const sweep_config &config, Cases &...cases) {
+    sweep_result result = run(config, cases...);
+    write_csv(path, result);
+    return result;
+}
+
+}  // namespace complexity
+
+#endif  // NATIVE_COMPLEXITY_HPP
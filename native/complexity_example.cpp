@@ -0,0 +1,66 @@
+// complexity_example.cpp - complexity.hpp 사용 예
+//
+// 상수/로그/선형/n log n 예제를 스윕해 native_complexity.csv로 저장한다.
+// 사용법: ./complexity_example [N_MAX] [--geometric] [--tsc]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "complexity.hpp"
+
+static std::vector<int> random_vector(std::size_t n) {
+    static std::mt19937 rng(12345);
+    std::vector<int> values(n);
+    for (int &value : values) {
+        value = (int)rng();
+    }
+    return values;
+}
+
+int main(int argc, char **argv) {
+    complexity::sweep_config config;
+    config.n_max = 10000;
+    config.n_step = 100;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--geometric") == 0) {
+            config.geometric = true;
+        } else if (std::strcmp(argv[i], "--tsc") == 0) {
+            config.force_tsc = true;
+        } else {
+            config.n_max = std::strtoul(argv[i], nullptr, 10);
+        }
+    }
+
+    // 상수: 벡터 가운데 원소 읽기
+    auto index = complexity::make_case("index",
+        [](std::size_t n) { return random_vector(n); },
+        [](std::vector<int> &v) { return v[v.size() / 2]; });
+
+    // 로그: 정렬된 집합에서 탐색
+    auto set_find = complexity::make_case("set_find",
+        [](std::size_t n) {
+            std::vector<int> v = random_vector(n);
+            return std::set<int>(v.begin(), v.end());
+        },
+        [](std::set<int> &s) { return s.find(42) != s.end(); });
+
+    // 선형: 합계
+    auto sum = complexity::make_case("sum",
+        [](std::size_t n) { return random_vector(n); },
+        [](std::vector<int> &v) { return std::accumulate(v.begin(), v.end(), 0LL); });
+
+    // n log n: 정렬 (반복마다 새 입력)
+    auto sort = complexity::make_case("sort",
+        [](std::size_t n) { return random_vector(n); },
+        [](std::vector<int> &v) { std::sort(v.begin(), v.end()); });
+
+    complexity::run_to_csv("native_complexity.csv", config, index, set_find, sum, sort);
+    std::printf("saved native_complexity.csv (%zu..%zu)\n", config.n_min, config.n_max);
+    return 0;
+}
@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""바이너리 열(columnar) 결과 파일 (.ttr)
+
+CSV의 "1.7e-05" 같은 손실 있는 텍스트 대신 원시 int64 값(나노초 또는 사이클)을
+열 단위로 저장한다. 행 하나가 샘플 하나이며 같은 n이 여러 번 나올 수 있다(반복 측정).
+
+헤더의 layout에 따라 열의 뜻이 다르다.
+  columns  names 순서의 코드별 시간 열 (import한 CSV처럼 이미 가공된 값)
+  samples  측정 샘플 그대로: code(codes의 번호), raw_ns(묶음 전체 시간), loops(묶음 반복 수),
+           overhead_ns(그 묶음의 타이머+반복 오버헤드). 1회당 시간은
+           max(raw_ns - overhead_ns, 0) / loops이고 sweep()이 계산한다.
+
+파일 구조 (리틀 엔디언, 모든 구역은 8바이트 정렬):
+  0   magic      8바이트 "TTRES1\\0\\0"
+  8   header_len uint32  JSON 헤더 바이트 수 (패딩 제외)
+  12  reserved   uint32
+  16  header     UTF-8 JSON: names, rows, unit, machine, overhead 등
+  ..  columns    int64 x rows: n 열 다음에 names 순서의 열들
+
+ResultFile은 파일을 mmap하고 열을 memoryview('q')로 그대로 돌려주므로 복사 없이
+수백만 샘플도 밀리초 안에 연다. 열 view를 들고 있는 동안에는 close할 수 없다.
+
+명령행:
+  python3 resultfile.py info results.ttr
+  python3 resultfile.py export results.ttr results.csv     # save_benchmark_to_csv 형식(초)
+  python3 resultfile.py import linear.csv linear.ttr       # 기존 CSV(초) -> ns
+"""
+import array
+import csv
+import json
+import mmap
+import os
+import platform
+import statistics
+import struct
+import sys
+import time
+
+MAGIC = b"TTRES1\0\0"
+PREAMBLE = struct.Struct("<8sII")
+ALIGN = 8
+TICKS_PER_SECOND = {"ns": 1e9}  # 사이클 단위는 헤더의 cycles_per_second 사용
+SAMPLE_COLUMNS = ["code", "raw_ns", "loops", "overhead_ns"]
+
+
+def _padded(size: int) -> int:
+    return (size + ALIGN - 1) // ALIGN * ALIGN
+
+
+def machine_metadata() -> dict:
+    """결과를 만든 기계 정보"""
+    cpu_model = platform.processor()
+    try:
+        with open("/proc/cpuinfo", encoding="utf-8") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    cpu_model = line.split(":", 1)[1].strip()
+                    break
+    except OSError:
+        pass
+    clock = time.get_clock_info("perf_counter")
+    return {
+        "host": platform.node(),
+        "machine": platform.machine(),
+        "cpu": cpu_model,
+        "cpus": os.cpu_count(),
+        "os": platform.platform(),
+        "python": platform.python_version(),
+        "clock": clock.implementation,
+        "clock_resolution": clock.resolution,
+    }
+
+
+def write_result_file(path, names, ns, columns, unit="ns", extra=None):
+    """names 순서의 columns(각각 ns와 같은 길이의 정수 목록)를 저장한다.
+
+    extra는 헤더에 그대로 들어가는 추가 정보(예: {"overhead_ns": 397}).
+    임시 파일에 쓰고 fsync한 뒤 os.replace로 바꿔 끼운다.
+    """
+    if len(names) != len(columns):
+        raise ValueError("names and columns differ in length")
+    rows = len(ns)
+    for name, column in zip(names, columns):
+        if len(column) != rows:
+            raise ValueError(f"column {name} has {len(column)} rows, expected {rows}")
+
+    header = {
+        "names": list(names),
+        "rows": rows,
+        "unit": unit,
+        "created": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "machine": machine_metadata(),
+    }
+    header.update(extra or {})
+    header_bytes = json.dumps(header, ensure_ascii=False).encode("utf-8")
+
+    temp = path + ".tmp"
+    with open(temp, "wb") as f:
+        f.write(PREAMBLE.pack(MAGIC, len(header_bytes), 0))
+        f.write(header_bytes.ljust(_padded(len(header_bytes)), b"\0"))
+        for column in [ns] + list(columns):
+            values = column if isinstance(column, array.array) and column.typecode == "q" \
+                else array.array("q", column)
+            if sys.byteorder != "little":
+                values = array.array("q", values)
+                values.byteswap()
+            values.tofile(f)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(temp, path)
+
+
+def write_sample_file(path, codes, samples, extra=None):
+    """측정 샘플을 가공 없이 samples 레이아웃으로 저장한다.
+
+    codes는 코드 이름 목록, samples는 (코드 번호, n, raw_ns, loops, overhead_ns) 목록.
+    overhead_ns는 반복 오버헤드 때문에 소수일 수 있어 정수 ns로 반올림한다.
+    """
+    ns = [sample[1] for sample in samples]
+    columns = [[sample[0] for sample in samples],
+               [sample[2] for sample in samples],
+               [sample[3] for sample in samples],
+               [round(sample[4]) for sample in samples]]
+    write_result_file(path, SAMPLE_COLUMNS, ns, columns,
+                      extra={"layout": "samples", "codes": list(codes), **(extra or {})})
+
+
+class ResultFile:
+    """.ttr 파일의 메모리 매핑 리더"""
+
+    def __init__(self, path):
+        self.path = path
+        with open(path, "rb") as f:
+            size = os.fstat(f.fileno()).st_size
+            if size < PREAMBLE.size:
+                raise ValueError(f"{path}: too small for a result file")
+            self._map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, header_len, _ = PREAMBLE.unpack_from(self._map, 0)
+        if magic != MAGIC:
+            self._map.close()
+            raise ValueError(f"{path}: not a result file (bad magic)")
+        start = PREAMBLE.size
+        self.header = json.loads(bytes(self._map[start:start + header_len]).decode("utf-8"))
+        self.names = self.header["names"]
+        self.rows = self.header["rows"]
+        self.unit = self.header["unit"]
+        self.layout = self.header.get("layout", "columns")
+        self._data = start + _padded(header_len)
+
+        expected = self._data + 8 * self.rows * (len(self.names) + 1)
+        if size < expected:
+            self._map.close()
+            raise ValueError(f"{path}: truncated ({size} bytes, expected {expected})")
+        if sys.byteorder != "little":
+            raise NotImplementedError("zero-copy reader requires a little-endian host")
+        self._view = memoryview(self._map)
+
+    def _column(self, index):
+        offset = self._data + 8 * self.rows * index
+        return self._view[offset:offset + 8 * self.rows].cast("q")
+
+    @property
+    def n(self):
+        """n 열 (int64 memoryview, 복사 없음)"""
+        return self._column(0)
+
+    def column(self, name):
+        """이름의 열 (int64 memoryview, 복사 없음)"""
+        return self._column(1 + self.names.index(name))
+
+    def columns(self):
+        """names 순서의 모든 열 (이름이 겹쳐도 위치로 구분)"""
+        return [self._column(1 + j) for j in range(len(self.names))]
+
+    def ticks_per_second(self):
+        """초당 값 단위 수 (ns면 1e9, 사이클이면 헤더의 cycles_per_second)"""
+        if self.unit == "cycles":
+            return self.header["cycles_per_second"]
+        return TICKS_PER_SECOND[self.unit]
+
+    def sweep(self):
+        """(n 목록, [(이름, 초 단위 시간 목록)]). columns 레이아웃은 행과 열 그대로,
+        samples 레이아웃은 샘플마다 1회당 시간을 계산해 (n, 코드)별 중앙값을 쓴다
+        (모든 코드에 샘플이 있는 n만, n 순서)."""
+        ticks = self.ticks_per_second()
+        if self.layout != "samples":
+            return list(self.n), [(name, [value / ticks for value in column])
+                                  for name, column in zip(self.names, self.columns())]
+
+        codes = self.header["codes"]
+        by_n = {}
+        code, raw, loops, overhead = (self.column(name) for name in SAMPLE_COLUMNS)
+        for i, n in enumerate(self.n):
+            per_code = by_n.setdefault(n, [[] for _ in codes])
+            per_code[code[i]].append(max(raw[i] - overhead[i], 0) / loops[i] / ticks)
+        for view in (code, raw, loops, overhead):
+            view.release()
+        ns = sorted(n for n, per_code in by_n.items() if all(per_code))
+        return ns, [(name, [statistics.median(by_n[n][j]) for n in ns])
+                    for j, name in enumerate(codes)]
+
+    def to_csv(self, path):
+        """save_benchmark_to_csv와 같은 "n,<이름>,..." 형식(초)으로 내보낸다"""
+        ns, columns = self.sweep()
+        with open(path, "w", newline="", encoding="utf-8") as csvfile:
+            writer = csv.writer(csvfile)
+            writer.writerow(["n"] + [name for name, _ in columns])
+            for i, n in enumerate(ns):
+                writer.writerow([n] + [times[i] for _, times in columns])
+
+    def close(self):
+        self._view.release()
+        self._map.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        self.close()
+        return False
+
+
+def import_csv(csv_path, path):
+    """save_benchmark_to_csv 형식(초)의 CSV를 .ttr(ns)로 변환"""
+    with open(csv_path, newline="", encoding="utf-8") as csvfile:
+        reader = csv.reader(csvfile)
+        header = next(reader)
+        rows = [row for row in reader if row]
+    ns = [int(float(row[0])) for row in rows]
+    columns = [[round(float(row[j]) * 1e9) for row in rows] for j in range(1, len(header))]
+    write_result_file(path, header[1:], ns, columns, extra={"source": os.path.basename(csv_path)})
+
+
+def main(argv):
+    if len(argv) == 2 and argv[0] == "info":
+        start = time.perf_counter()
+        with ResultFile(argv[1]) as result:
+            elapsed = time.perf_counter() - start
+            print(f"{argv[1]}: {result.rows} rows x {len(result.names)} columns ({result.unit}), "
+                  f"opened in {elapsed * 1e3:.2f} ms")
+            print(json.dumps(result.header, indent=2, ensure_ascii=False))
+    elif len(argv) == 3 and argv[0] == "export":
+        with ResultFile(argv[1]) as result:
+            result.to_csv(argv[2])
+    elif len(argv) == 3 and argv[0] == "import":
+        import_csv(argv[1], argv[2])
+    else:
+        print(__doc__.split("명령행:")[1].rstrip())
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
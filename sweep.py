@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""로그 간격 + 적응형 n 스윕 모듈
+
+range(n_range)를 1씩 훑는 대신 n을 기하급수로 배치하고(옥타브당 per_octave개),
+지점마다 repeats번 측정한 중앙값을 쓴다. adaptive_sweep은 거친 로그 스윕에서
+시작해 다음 두 곳에만 기하 중점을 추가한다.
+  - 로그-로그 기울기가 인접 구간 사이에서 SLOPE_CHANGE 이상 바뀌는 곳
+  - complexity_fit의 최적 모델 대비 상대 잔차가 RESIDUAL_LIMIT을 넘는 곳
+MIN_RESOLVED보다 짧은 지점은 타이머 잡음이 지배하므로 세분 판단에 쓰지 않는다.
+
+결과는 (n 목록, 코드별 초 단위 시간 목록)이며 save_benchmark_to_csv(..., ns=n 목록)
+으로 저장하면 complexity_fit.py가 그대로 읽는다. SweepJob은 같은 스윕을 별도 프로세스에서
+돌리고 진행 상황과 샘플을 큐로 돌려준다 (time-test-gui.py).
+"""
+import contextlib
+import math
+import multiprocessing
+import queue
+import statistics
+
+from complexity_fit import MODELS, best_fit, fit_column
+from timetest import DEFAULT_SETUP, SweepPool, parallel_sweep, start_sample_log, time_test
+
+DEFAULT_PER_OCTAVE = 4
+DEFAULT_REPEATS = 5
+SLOPE_CHANGE = 0.5      # 인접 구간의 로그-로그 기울기 차이가 이보다 크면 세분
+RESIDUAL_LIMIT = 0.25   # 최적 모델 대비 상대 잔차가 이보다 크면 세분
+MAX_ROUNDS = 4          # 세분 반복 횟수 상한
+REFINE_PER_ROUND = 8    # 한 번에 세분하는 구간 수 상한 (점수 순)
+MAX_POINTS = 200        # 전체 지점 수 상한
+MIN_TIME = 1e-9         # 로그 계산용 하한 (오버헤드를 뺀 시간은 0일 수 있다)
+MIN_RESOLVED = 1e-5     # 이보다 짧은 시간은 잡음이 지배하므로 세분 판단에서 제외
+
+MODEL_FUNCTIONS = {name: f for _, name, f in MODELS}
+
+
+def geometric_points(n_max: int, n_min: int = 1, per_octave: int = DEFAULT_PER_OCTAVE) -> list:
+    """n_min..n_max를 옥타브당 per_octave개로 나눈 정수 n 목록 (중복 제거, 양 끝 포함)"""
+    if n_min < 1 or n_max < n_min:
+        raise ValueError("need 1 <= n_min <= n_max")
+    points = set()
+    steps = max(1, math.ceil(math.log2(n_max / n_min) * per_octave))
+    for k in range(steps + 1):
+        points.add(min(n_max, round(n_min * 2 ** (k / per_octave))))
+    points.add(n_max)
+    return sorted(points)
+
+
+def measure_points(code: str, ns: list, repeats: int = DEFAULT_REPEATS, jobs: int = 1,
+                   setup: str = DEFAULT_SETUP, progress=None) -> list:
+    """각 n을 repeats번 측정해 중앙값(초) 목록을 반환. jobs != 1이면 parallel_sweep 사용"""
+    tasks = [n for n in ns for _ in range(repeats)]
+    if jobs != 1:
+        samples, _ = parallel_sweep(code, tasks, jobs, setup, progress)
+    else:
+        samples = []
+        for done, n in enumerate(tasks, start=1):
+            samples.append(time_test(code, n))
+            if progress:
+                progress(done, len(tasks))
+    return [statistics.median(samples[i * repeats:(i + 1) * repeats]) for i in range(len(ns))]
+
+
+def loglog_slopes(ns: list, times: list) -> list:
+    """구간 i (ns[i]..ns[i+1])의 로그-로그 기울기"""
+    slopes = []
+    for i in range(len(ns) - 1):
+        t0, t1 = max(times[i], MIN_TIME), max(times[i + 1], MIN_TIME)
+        slopes.append(math.log(t1 / t0) / math.log(ns[i + 1] / ns[i]))
+    return slopes
+
+
+def interval_scores(ns: list, times: list) -> dict:
+    """세분할 구간 번호 -> 점수 (기준 대비 배수, 1보다 큰 것만)"""
+    scores = {}
+
+    def flag(interval, score):
+        if score > 1.0 and 0 <= interval < len(ns) - 1:
+            scores[interval] = max(scores.get(interval, 0.0), score)
+
+    slopes = loglog_slopes(ns, times)
+    for i in range(1, len(slopes)):
+        if times[i + 1] < MIN_RESOLVED:
+            continue
+        score = abs(slopes[i] - slopes[i - 1]) / SLOPE_CHANGE
+        flag(i - 1, score)
+        flag(i, score)
+
+    if len(ns) >= 3:
+        best = best_fit(fit_column(ns, times))
+        f = MODEL_FUNCTIONS[best.name]
+        for j, (n, t) in enumerate(zip(ns, times)):
+            if t < MIN_RESOLVED:
+                continue
+            fitted = best.a + (best.b * f(max(n, 1)) if f else 0.0)
+            scale = max(abs(fitted), t, MIN_TIME)
+            score = abs(t - fitted) / scale / RESIDUAL_LIMIT
+            flag(j - 1, score)
+            flag(j, score)
+    return scores
+
+
+def measure_rows(codes: list, ns: list, repeats: int = DEFAULT_REPEATS, jobs: int = 1,
+                 progress=None, pool: SweepPool = None):
+    """n마다 (n, 코드별 중앙값 목록)을 내놓는다. 순차 실행은 n 순서로 하나가 끝날 때마다,
+    병렬 실행은 모든 코드 x repeats개의 샘플이 모인 n부터 끝난 순서대로 내놓는다.
+    병렬 실행은 pool(codes로 만든 SweepPool)을 쓰고, 없으면 이 호출 동안 풀 하나를 띄운다."""
+    if jobs != 1 and pool is None:
+        with SweepPool(codes, jobs) as own_pool:
+            yield from measure_rows(codes, ns, repeats, jobs, progress, own_pool)
+        return
+    if pool is not None:
+        # n 순서로 넣으므로 작은 n부터 채워진다. n별 완료 버퍼에 모아 다 찬 행부터 내보낸다
+        tasks = [((i, j), code, n) for i, n in enumerate(ns)
+                 for j, code in enumerate(codes) for _ in range(repeats)]
+        samples = [[[] for _ in codes] for _ in ns]
+        remaining = [len(codes) * repeats] * len(ns)
+        for done, ((i, j), seconds, _, _) in enumerate(pool.imap_unordered(tasks), start=1):
+            samples[i][j].append(seconds)
+            remaining[i] -= 1
+            if progress:
+                progress(done, len(tasks))
+            if remaining[i] == 0:
+                yield ns[i], [statistics.median(column) for column in samples[i]]
+                samples[i] = None
+        return
+    for done, n in enumerate(ns, start=1):
+        yield n, [measure_points(code, [n], repeats)[0] for code in codes]
+        if progress:
+            progress(done, len(ns))
+
+
+def adaptive_sweep(codes: list, n_max: int, n_min: int = 1,
+                   per_octave: int = 2, repeats: int = DEFAULT_REPEATS,
+                   adaptive: bool = True, jobs: int = 1, progress=None,
+                   known=None, on_point=None):
+    """여러 코드를 같은 n 지점들에서 측정한다. 어느 코드든 세분이 필요하면 그 구간에
+    모든 코드의 새 지점을 추가한다. 반환값은 (n 목록, [코드별 시간 목록]).
+
+    known({n: 코드별 값 목록}, 예: ResultStream.recorded)에 있는 지점은 다시 재지 않고,
+    새로 잰 지점마다 on_point(n, 값 목록)을 호출한다 (중단 후 이어 하기용).
+    병렬 실행(jobs != 1)은 모든 라운드가 워커 풀 하나를 같이 쓴다."""
+    with SweepPool(codes, jobs) if jobs != 1 else contextlib.nullcontext() as pool:
+        return _adaptive_rounds(codes, n_max, n_min, per_octave, repeats, adaptive, jobs,
+                                progress, known, on_point, pool)
+
+
+def _adaptive_rounds(codes, n_max, n_min, per_octave, repeats, adaptive, jobs, progress,
+                     known, on_point, pool):
+    rows = dict(known or {})
+
+    def measure_missing(points):
+        todo = [n for n in points if n not in rows]
+        for n, values in measure_rows(codes, todo, repeats, jobs, progress, pool):
+            rows[n] = values
+            if on_point:
+                on_point(n, values)
+
+    ns = geometric_points(n_max, n_min, per_octave)
+    measure_missing(ns)
+
+    for _ in range(MAX_ROUNDS if adaptive else 0):
+        scores = {}
+        for j in range(len(codes)):
+            for interval, score in interval_scores(ns, [rows[n][j] for n in ns]).items():
+                scores[interval] = max(scores.get(interval, 0.0), score)
+
+        # 점수가 높은 구간부터 REFINE_PER_ROUND개까지만 기하 중점을 추가
+        worst = sorted(scores, key=scores.get, reverse=True)[:REFINE_PER_ROUND]
+        new_points = sorted({round(math.sqrt(ns[i] * ns[i + 1])) for i in worst} - set(ns))
+        new_points = [n for n in new_points if n_min < n < n_max][:MAX_POINTS - len(ns)]
+        if not new_points:
+            break
+        measure_missing(new_points)
+        ns = sorted(ns + new_points)
+
+    return ns, [[rows[n][j] for n in ns] for j in range(len(codes))]
+
+
+# ============ 백그라운드 스윕 작업 (GUI용) ============
+
+class _Stopped(Exception):
+    pass
+
+
+def _sweep_job_main(messages, stop, code, n_max, mode, repeats, per_octave):
+    # 별도 프로세스에서 실행: 측정만 하고 결과는 큐로만 보낸다
+    log = start_sample_log()
+
+    def progress(done, total):
+        messages.put(("progress", done, total))
+
+    def on_point(n, values):
+        messages.put(("sample", n, values[0]))
+        for _, result in log:
+            messages.put(("raw", result.n, result.raw_ns, result.loops, result.overhead_ns))
+        log.clear()
+        if stop.is_set():
+            raise _Stopped()
+
+    try:
+        if mode == "linear":
+            for n in range(n_max):
+                on_point(n, [time_test(code, n)])
+                progress(n + 1, n_max)
+        else:
+            adaptive_sweep([code], n_max, per_octave=per_octave, repeats=repeats,
+                           adaptive=mode == "adaptive", progress=progress, on_point=on_point)
+        messages.put(("done",))
+    except _Stopped:
+        messages.put(("stopped",))
+    except Exception as error:   # 사용자 코드의 예외도 GUI에 알린다
+        messages.put(("error", f"{type(error).__name__}: {error}"))
+
+
+class SweepJob:
+    """스윕을 별도 프로세스에서 실행한다. 호출한 쪽(GUI 스레드)은 poll()로 메시지만 받는다.
+
+    메시지: ("progress", done, total), ("sample", n, 초), ("raw", n, raw_ns, loops, overhead_ns),
+    ("done",), ("stopped",), ("error", 문자열). raw는 sample 하나를 만든 측정 샘플들이다.
+    측정 프로세스는 CPU 하나를 GUI 이벤트 루프와 GIL 경쟁 없이 쓴다.
+    """
+
+    def __init__(self, code: str, n_max: int, mode: str = "linear",
+                 repeats: int = DEFAULT_REPEATS, per_octave: int = 2):
+        context = multiprocessing.get_context("fork")
+        self.messages = context.Queue()
+        self._stop = context.Event()
+        self.process = context.Process(
+            target=_sweep_job_main, daemon=True,
+            args=(self.messages, self._stop, code, n_max, mode, repeats, per_octave))
+        self.process.start()
+
+    def poll(self, limit=10000) -> list:
+        """기다리지 않고 쌓인 메시지를 최대 limit개(None이면 전부) 꺼낸다"""
+        received = []
+        while limit is None or len(received) < limit:
+            try:
+                received.append(self.messages.get_nowait())
+            except queue.Empty:
+                break
+        return received
+
+    def cancel(self):
+        """다음 지점이 끝나면 멈추게 한다"""
+        self._stop.set()
+
+    @property
+    def running(self) -> bool:
+        return self.process.is_alive()
@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""complexity_fit 모델 선택 검사 (python3 -m unittest test_complexity_fit)
+
+O(n)과 O(n log n)은 측정 범위에서 R²가 거의 같으므로, 정확한 데이터와
+잡음 섞인 데이터 모두에서 둘을 구분하는지 본다.
+"""
+import math
+import random
+import unittest
+
+from complexity_fit import best_fit, fit_column, runs_z_score
+
+NS = [float(1000 * 2 ** (k / 2)) for k in range(20)]      # 1e3 .. ~7e5
+
+
+def noisy(ts, relative, seed):
+    rng = random.Random(seed)
+    return [t * (1.0 + rng.gauss(0.0, relative)) for t in ts]
+
+
+class ModelSelectionTest(unittest.TestCase):
+    def assertBest(self, ts, expected):
+        best = best_fit(fit_column(NS, ts))
+        self.assertEqual(best.name, expected, best)
+
+    def test_exact_linear(self):
+        self.assertBest([2e-6 + 3e-9 * n for n in NS], "O(n)")
+
+    def test_exact_nlogn(self):
+        self.assertBest([1e-6 + 5e-10 * n * math.log2(n) for n in NS], "O(n log n)")
+
+    def test_noisy_linear(self):
+        self.assertBest(noisy([2e-6 + 3e-9 * n for n in NS], 0.02, 1), "O(n)")
+
+    def test_noisy_nlogn(self):
+        self.assertBest(noisy([1e-6 + 5e-10 * n * math.log2(n) for n in NS], 0.02, 2), "O(n log n)")
+
+    def test_constant_noise(self):
+        self.assertBest(noisy([1e-3] * len(NS), 0.02, 3), "O(1)")
+
+    def test_exact_fit_passes_runs_test(self):
+        fits = fit_column(NS, [4e-9 * n for n in NS])
+        linear = next(fit for fit in fits if fit.name == "O(n)")
+        self.assertTrue(linear.residuals_ok, linear)
+
+    def test_runs_ignores_rounding_residuals(self):
+        self.assertEqual(runs_z_score([1e-20, 2e-20, 1e-20, 3e-20], tolerance=1e-15), 0.0)
+        self.assertEqual(runs_z_score([1.0, 2.0, 1.0, 3.0]), -math.inf)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,13 +1,27 @@
+import argparse
+import contextlib
 import csv
 import sys
 import math
 from timetest import *
+from sweep import adaptive_sweep, measure_rows
+from resultfile import write_sample_file
 
 
-def test(input_code: str, n_range: int):
+def show_progress(done: int, total: int):
+    print(f"test progress: {done}/{total}", end="\r")
+
+
+def test(input_code: str, n_range: int, pool=None):
+    if jobs != 1:
+        result, stats = parallel_sweep(input_code, n_range, jobs, progress=show_progress, pool=pool)
+        print()
+        print_worker_stats(stats)
+        return result
+
     result = list()
     for i in range(n_range):
-        print(f"test progress: {i + 1}/{n_range}", end="\r")
+        show_progress(i + 1, n_range)
         test_result = time_test(input_code, i)
         result.append(test_result)
     for i in result:
@@ -32,7 +46,33 @@ def get_multiline_input(prompt=""):
     return "\n".join(lines)
 
 
+arg_parser = argparse.ArgumentParser(description="python code time test program")
+arg_parser.add_argument("-j", "--jobs", type=int, default=1,
+                        help="n 값을 CPU에 고정된 워커 프로세스 N개로 나눠 측정 (0 = 사용 가능한 CPU 전부)")
+arg_parser.add_argument("--sweep", choices=["linear", "log", "adaptive"], default="linear",
+                        help="linear: n = 0..range-1, log: 로그 간격, adaptive: 로그 간격 + 곡선이 휘는 곳 세분")
+arg_parser.add_argument("--repeats", type=int, default=5, help="log/adaptive 지점당 반복 횟수 (중앙값 사용)")
+arg_parser.add_argument("--per-octave", type=int, default=2, help="log/adaptive 옥타브당 시작 지점 수")
+arg_parser.add_argument("-o", "--output", help="결과를 n마다 이 CSV에 바로 기록 (중단돼도 남는다)")
+arg_parser.add_argument("--resume", action="store_true", help="--output 파일에 이미 있는 n은 건너뛰고 이어서 측정")
+arg_parser.add_argument("--controlled", action="store_true",
+                        help="측정 중 gc 끄기, 워밍업, getrusage로 OS 방해 샘플 다시 재기")
+arg_parser.add_argument("--cpu", type=int, help="--controlled에서 고정할 CPU (병렬 모드는 워커별로 고정)")
+arg_parser.add_argument("--warmup", type=int, default=WARMUP_PASSES, help="--controlled 측정 전 워밍업 횟수")
+args = arg_parser.parse_args()
+jobs = args.jobs
+if args.controlled:
+    set_controlled(True, args.cpu if jobs == 1 else None, args.warmup)
+
 print("python code time test program")
+describe_timer()
+if args.controlled:
+    print(f"controlled mode: gc off while timing, {args.warmup} warmup passes"
+          f"{f', pinned to CPU {args.cpu}' if args.cpu is not None and jobs == 1 else ''}")
+if jobs != 1:
+    workers = sweep_worker_count(jobs)
+    print(f"parallel sweep: {workers} workers on CPUs {available_cpus()}"
+          f"{f' (--jobs {jobs} clamped to the CPU count)' if jobs > workers else ''}")
 code_number = input("the number of code: ")
 try:
     test_number = int(code_number)
@@ -52,15 +92,66 @@ for i in range(test_number):
     code_lists.append(code)
 
 nRange = int(input("range: "))
+# .ttr로 저장할 수 있도록 중앙값이 아닌 측정 샘플 자체도 모아 둔다
+raw_samples = start_sample_log()
+
+
+def stream_sweep(stream):
+    """n 하나가 끝날 때마다 stream에 기록. 이미 기록된 n은 건너뛴다."""
+    if stream.done:
+        print(f"resuming: {len(stream.done)} points already in {args.output}")
+    if args.sweep == "linear":
+        todo = [i for i in range(nRange) if i not in stream.done]
+        for n, values in measure_rows(code_lists, todo, 1, jobs, show_progress):
+            stream.write(n, values)
+    else:
+        adaptive_sweep(code_lists, nRange, per_octave=args.per_octave, repeats=args.repeats,
+                       adaptive=args.sweep == "adaptive", jobs=jobs, progress=show_progress,
+                       known=stream.recorded, on_point=stream.write)
+    print()
+
+
+if args.output:
+    # 스트리밍 저장: 중단되면 같은 명령에 --resume을 붙여 이어서 측정
+    try:
+        with ResultStream(args.output, test_list, resume=args.resume) as stream:
+            stream_sweep(stream)
+    except KeyboardInterrupt:
+        print(f"\ninterrupted: {len(stream.done)} points saved in {args.output} (rerun with --resume)")
+        sys.exit(130)
+    print(f"saved {len(stream.done)} points to {args.output}")
+    if args.controlled and jobs == 1:
+        describe_disturbances()
+    sys.exit(0)
+
 result = list()
-for code in code_lists:
-    test_result = test(code, nRange)
-    result.append(test_result)
+ns = None
+if args.sweep == "linear":
+    # 병렬 실행은 모든 코드가 워커 풀 하나를 같이 쓴다
+    with SweepPool(code_lists, jobs) if jobs != 1 else contextlib.nullcontext() as pool:
+        for code in code_lists:
+            test_result = test(code, nRange, pool)
+            result.append(test_result)
+else:
+    # 로그/적응형: range는 최대 n, 지점마다 repeats번 측정한 중앙값
+    ns, result = adaptive_sweep(code_lists, nRange, per_octave=args.per_octave,
+                                repeats=args.repeats, adaptive=args.sweep == "adaptive",
+                                jobs=jobs, progress=show_progress)
+    print()
+    print(f"{len(ns)} points: {ns}")
+
+if args.controlled and jobs == 1:
+    describe_disturbances()
 
 isSaveResult = input("do you want to save the result? (y/n)")
 if isSaveResult == "y":
-    save_location = input("input save location: ")
-    save_benchmark_to_csv(test_list, result, save_location)
+    save_location = input("input save location (.csv or .ttr): ")
+    if save_location.endswith(".ttr"):
+        # 바이너리 열 형식: 샘플마다 raw_ns, loops, overhead_ns 그대로 (resultfile.py export로 CSV 변환)
+        write_sample_file(save_location, test_list, sample_rows(raw_samples, code_lists),
+                          extra={**timer_info(), "sweep": args.sweep})
+    else:
+        save_benchmark_to_csv(test_list, result, save_location, ns)
     print("saved successfully!")
 else:
     for i in result:
@@ -1,46 +1,148 @@
 import tkinter.messagebox
 import tkinter.filedialog
 import tkinter
-import csv
 from timetest import *
+from sweep import SweepJob
+from resultfile import write_sample_file
+
+POLL_MS = 50            # 작업 큐 확인 주기
+PLOT_WIDTH = 760
+PLOT_HEIGHT = 260
+PLOT_MARGIN = 50
+
+job = None              # 실행 중인 SweepJob
+samples = dict()        # n -> 초 (같은 n이 다시 오면 최신 값)
+rawSamples = list()     # .ttr 저장용 측정 샘플 (0, n, raw_ns, loops, overhead_ns)
+plotDirty = False
+
 
 def test(input_code: str, n_range: int):
-    test_info = tkinter.Toplevel(window)
-    test_info.title("test info")
-    test_info.geometry("300x200")
-    test_info_msg = tkinter.Label(test_info, text = "test progress: 0/0")
-    test_info_msg.pack()
-    window.update()
-    test_info.update()
-    result = list()
-    for i in range(n_range):
-        test_info_msg.config(text = f"test progress: {i+1}/{n_range}")
-        test_info.update()
-        test_result = time_test(input_code, i)
-        result.append(test_result)
-    test_info.destroy()
+    """스윕을 백그라운드 프로세스로 시작. GUI 스레드는 poll_job으로 결과만 받는다."""
+    global job, plotDirty
+    if job is not None:
+        return
+    samples.clear()
+    rawSamples.clear()
+    plotDirty = True
+    job = SweepJob(input_code, n_range, sweepMode.get())
+    startBtn.config(state=tkinter.DISABLED)
+    stopBtn.config(state=tkinter.NORMAL)
+    progressLbl.config(text="test progress: 0/0")
+    window.after(POLL_MS, poll_job)
+
+
+def stop_test():
+    if job is not None:
+        job.cancel()
+        progressLbl.config(text="stopping...")
+
+
+def poll_job():
+    global job, plotDirty
+    finished = None
+    running = job.running
+    # 프로세스가 끝났으면 남은 메시지를 모두 받기 위해 종료 확인을 먼저 한다
+    for message in job.poll(10000 if running else None):
+        kind = message[0]
+        if kind == "sample":
+            samples[message[1]] = message[2]
+            plotDirty = True
+        elif kind == "raw":
+            rawSamples.append((0,) + tuple(message[1:]))
+        elif kind == "progress":
+            progressLbl.config(text=f"test progress: {message[1]}/{message[2]}")
+        else:
+            finished = message
+
+    if plotDirty:
+        draw_plot()
+        plotDirty = False
+
+    if finished is None and running:
+        window.after(POLL_MS, poll_job)
+        return
+    if finished is None:
+        finished = ("error", "worker process exited unexpectedly")
+
+    job = None
+    startBtn.config(state=tkinter.NORMAL)
+    stopBtn.config(state=tkinter.DISABLED)
+    if finished[0] == "error":
+        progressLbl.config(text="test failed")
+        tkinter.messagebox.showerror("error", finished[1])
+        return
+    progressLbl.config(text=f"{'test was done' if finished[0] == 'done' else 'test was stopped'}: "
+                            f"{len(samples)} points")
+    finish_test()
+
+
+def finish_test():
+    if not samples:
+        return
     is_save_file = tkinter.messagebox.askyesno("finish", "test was done. do you want to save the result?")
     if is_save_file:
-        with open(tkinter.filedialog.asksaveasfilename(defaultextension=".csv"), "w", newline="") as f:
-            writer = csv.writer(f)
-            writer.writerow(["test_number", "test_time"])
+        save_location = tkinter.filedialog.asksaveasfilename(
+            defaultextension=".csv", filetypes=[("CSV", "*.csv"), ("binary result", "*.ttr")])
+        if not save_location:
+            tkinter.messagebox.showinfo("info", "test was not saved")
+            return
+        ns = sorted(samples)
+        times = [samples[n] for n in ns]
+        if save_location.endswith(".ttr"):
+            # 중앙값이 아닌 측정 샘플 그대로 (raw_ns, loops, overhead_ns)
+            write_sample_file(save_location, ["test_time"], rawSamples,
+                              extra={**timer_info(), "sweep": sweepMode.get()})
+        else:
+            save_benchmark_to_csv(["test_time"], [times], save_location, ns)
         tkinter.messagebox.showinfo("info", "test was saved")
     else:
         tkinter.messagebox.showinfo("info", "test was not saved")
-    for i in result:
-        meta_print(i)
+
+
+def draw_plot():
+    """n에 대한 시간 그래프를 다시 그린다 (축은 지금까지의 최댓값에 맞춤)"""
+    plotCanvas.delete("all")
+    left, top = PLOT_MARGIN, 10
+    right, bottom = PLOT_WIDTH - 10, PLOT_HEIGHT - 30
+    plotCanvas.create_line(left, top, left, bottom, right, bottom)
+    if not samples:
+        return
+
+    ns = sorted(samples)
+    n_max = max(ns[-1], 1)
+    t_max = max(samples.values()) or 1e-9
+    plotCanvas.create_text(left, bottom + 15, text="0", anchor="w")
+    plotCanvas.create_text(right, bottom + 15, text=f"n={n_max}", anchor="e")
+    plotCanvas.create_text(left - 5, top, text=f"{t_max * 1e6:.3g}µs", anchor="ne")
+
+    points = []
+    for n in ns:
+        x = left + (right - left) * n / n_max
+        y = bottom - (bottom - top) * samples[n] / t_max
+        points.append((x, y))
+    if len(points) > 1:
+        plotCanvas.create_line(*[c for point in points for c in point], fill="steelblue")
+    if len(points) <= 500:
+        for x, y in points:
+            plotCanvas.create_oval(x - 2, y - 2, x + 2, y + 2, outline="steelblue")
+
 
 window = tkinter.Tk()
-window.geometry("800x500")
+window.geometry("800x760")
 titleFrame = tkinter.Frame(window)
 rangeFrame = tkinter.Frame(window)
 startBtnFrame = tkinter.Frame(window)
 window.title("python code time test program")
 titleLbl = tkinter.Label(titleFrame, text = "python code time test program", font=("applegothic", 40))
-codeEntry = tkinter.Text(titleFrame, width=100)
+codeEntry = tkinter.Text(titleFrame, width=100, height=14)
 rangeEntryIndicatorLbl = tkinter.Label(rangeFrame, text = "range setting")
 rangeEntry = tkinter.Entry(rangeFrame)
+sweepMode = tkinter.StringVar(window, "linear")
+sweepMenu = tkinter.OptionMenu(rangeFrame, sweepMode, "linear", "log", "adaptive")
 startBtn = tkinter.Button(startBtnFrame, text="start", command=lambda: test(codeEntry.get("1.0", tkinter.END), int(rangeEntry.get())))
+stopBtn = tkinter.Button(startBtnFrame, text="stop", state=tkinter.DISABLED, command=stop_test)
+progressLbl = tkinter.Label(window, text = "")
+plotCanvas = tkinter.Canvas(window, width=PLOT_WIDTH, height=PLOT_HEIGHT, background="white")
 #mainloop
 #frames
 titleFrame.pack()
@@ -52,7 +154,13 @@ codeEntry.pack()
 #range input
 rangeEntryIndicatorLbl.grid(row = 1,column=2)
 rangeEntry.grid(row=1, column=3)
-#start button
-startBtn.pack()
+sweepMenu.grid(row=1, column=4)
+#start/stop button
+startBtn.pack(side=tkinter.LEFT)
+stopBtn.pack(side=tkinter.LEFT)
+#progress & live plot
+progressLbl.pack()
+plotCanvas.pack()
+draw_plot()
 
-window.mainloop()
\ No newline at end of file
+window.mainloop()
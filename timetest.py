@@ -1,47 +1,471 @@
-import datetime
+import ast
+import gc
 import math
 import csv
+import multiprocessing
+import os
 import random
+import statistics
+import time
+
+try:
+    import resource
+except ImportError:     # getrusage가 없는 플랫폼에서는 rusage를 기록하지 않는다
+    resource = None
+
+# 같은 코드 문자열은 한 번만 컴파일한다
+_compiled_cache = {}
+
+def compile_snippet(code: str):
+    """코드 문자열을 exec용 코드 객체로 컴파일 (캐시)"""
+    compiled = _compiled_cache.get(code)
+    if compiled is None:
+        compiled = compile(code, "<time_test>", "exec")
+        _compiled_cache[code] = compiled
+    return compiled
 
 def const(n: int = 1, code: str = "k=n+1"):
-    exec(code)
+    exec(compile_snippet(code))
 
 def lg(n, base: int = 2, code: str = "k=n+1"):
+    compiled = compile_snippet(code)
     i = 1
     while i < n:
         i *= base
-        exec(code)
+        exec(compiled)
 
 def linear(n, code: str = "k=n+1"):
+    compiled = compile_snippet(code)
     for i in range(n):
-        exec(code)
+        exec(compiled)
 
 def factorial(n: int, code: str = "random.random()"):
+    compiled = compile_snippet(code)
     for i in range(math.factorial(n)):
-        exec(code)
+        exec(compiled)
 
 def square(n: int, exp: int = 2, code: str = "random.random()"):
+    compiled = compile_snippet(code)
     for i in range(n**exp):
-        exec(code)
+        exec(compiled)
 
 def exponential(n: int, base: int = 2, code: str = "random.random()"):
+    compiled = compile_snippet(code)
     for i in range(base**n):
-        exec(code)
+        exec(compiled)
 
 def meta_print(data: float):
     print(format(data, ".100f"))
 
+
+class TimingResult:
+    """한 번의 측정 결과 (나노초). 코드를 loops번 반복한 묶음 하나를 잰 값이며,
+    overhead_ns는 같은 묶음을 빈 코드(pass)로 잰 값이다."""
+
+    def __init__(self, n: int, raw_ns: int, overhead_ns: float, loops: int = 1):
+        self.n = n
+        self.raw_ns = raw_ns
+        self.overhead_ns = overhead_ns
+        self.loops = loops
+        self.rusage = None          # 통제 모드: 측정 구간의 getrusage 차이
+        self.reruns = 0             # 통제 모드: OS 방해로 다시 잰 횟수
+        self.disturbed = False      # 다시 재고도 방해받은 샘플
+
+    @property
+    def ns(self) -> float:
+        """오버헤드를 빼고 loops로 나눈 1회당 시간 (음수가 되면 0)"""
+        return max(self.raw_ns - self.overhead_ns, 0) / self.loops
+
+    @property
+    def seconds(self) -> float:
+        return self.ns / 1e9
+
+    def __repr__(self):
+        return (f"TimingResult(n={self.n}, raw_ns={self.raw_ns}, "
+                f"overhead_ns={self.overhead_ns:.0f}, loops={self.loops})")
+
+
+DEFAULT_SETUP = "test_list = list(range(n))"
+OVERHEAD_SAMPLES = 101
+RESOLUTION_SAMPLES = 1000
+BATCH_FACTOR = 1000     # 묶음 하나는 타이머 해상도의 이 배수 이상이 되도록 반복
+MAX_LOOPS = 1000000
+LOOP_CALIBRATION = 100000
+
+_overhead_ns = None
+_resolution_ns = None
+_loop_overhead_ns = None
+_batched_cache = {}
+
+def compile_batched(code: str):
+    """코드를 "for _ in range(_timetest_loops):" 본문으로 감싼 코드 객체 (캐시).
+
+    문자열 들여쓰기 대신 AST를 감싸므로 여러 줄 문자열도 그대로다. 최상위에서만
+    허용되는 구문(from __future__ 등) 때문에 감쌀 수 없으면 None.
+    """
+    if code not in _batched_cache:
+        tree = ast.parse(code, "<time_test>", "exec")
+        loop = ast.For(target=ast.Name("_timetest_i", ast.Store()),
+                       iter=ast.Call(ast.Name("range", ast.Load()),
+                                     [ast.Name("_timetest_loops", ast.Load())], []),
+                       body=tree.body or [ast.Pass()], orelse=[])
+        module = ast.fix_missing_locations(ast.Module(body=[loop], type_ignores=[]))
+        try:
+            _batched_cache[code] = compile(module, "<time_test>", "exec")
+        except SyntaxError:
+            _batched_cache[code] = None
+    return _batched_cache[code]
+
+def make_namespace(n: int, setup: str = DEFAULT_SETUP) -> dict:
+    """측정 코드가 실행될 이름공간: 이 모듈의 전역 + n + setup 결과"""
+    namespace = dict(globals())
+    namespace["n"] = n
+    if setup:
+        exec(compile_snippet(setup), namespace)
+    return namespace
+
+def _run_timed(compiled, namespace) -> int:
+    # 측정 구간에는 타이머 두 번과 exec 한 번만 들어간다
+    start = time.perf_counter_ns()
+    exec(compiled, namespace)
+    end = time.perf_counter_ns()
+    return end - start
+
+def timer_overhead_ns(refresh: bool = False) -> int:
+    """빈 코드(pass)를 측정한 값의 중앙값. 처음 한 번만 재고 캐시한다."""
+    global _overhead_ns
+    if _overhead_ns is None or refresh:
+        compiled = compile_snippet("pass")
+        namespace = {}
+        samples = sorted(_run_timed(compiled, namespace) for _ in range(OVERHEAD_SAMPLES))
+        _overhead_ns = samples[len(samples) // 2]
+    return _overhead_ns
+
+def timer_resolution_ns(refresh: bool = False) -> int:
+    """perf_counter_ns가 구분하는 가장 작은 0 아닌 간격 (연속 호출로 측정, 캐시)"""
+    global _resolution_ns
+    if _resolution_ns is None or refresh:
+        smallest = None
+        for _ in range(RESOLUTION_SAMPLES):
+            start = time.perf_counter_ns()
+            end = time.perf_counter_ns()
+            while end == start:
+                end = time.perf_counter_ns()
+            if smallest is None or end - start < smallest:
+                smallest = end - start
+        declared = math.ceil(time.get_clock_info("perf_counter").resolution * 1e9)
+        _resolution_ns = max(smallest, declared, 1)
+    return _resolution_ns
+
+def loop_overhead_ns(refresh: bool = False) -> float:
+    """묶음 반복 1회의 비용 (빈 코드를 LOOP_CALIBRATION번 돈 시간으로 계산, 캐시)"""
+    global _loop_overhead_ns
+    if _loop_overhead_ns is None or refresh:
+        compiled = compile_batched("pass")
+        samples = sorted(_run_timed(compiled, {"_timetest_loops": LOOP_CALIBRATION})
+                         for _ in range(5))
+        _loop_overhead_ns = max(samples[2] - timer_overhead_ns(), 0) / LOOP_CALIBRATION
+    return _loop_overhead_ns
+
+def batch_target_ns() -> int:
+    """묶음 하나의 목표 시간"""
+    return BATCH_FACTOR * timer_resolution_ns()
+
+def timer_info() -> dict:
+    """시작할 때 측정한 타이머 특성"""
+    return {"resolution_ns": timer_resolution_ns(), "overhead_ns": timer_overhead_ns(),
+            "loop_overhead_ns": loop_overhead_ns(), "batch_target_ns": batch_target_ns()}
+
+def describe_timer():
+    info = timer_info()
+    print(f"timer: perf_counter_ns, resolution {info['resolution_ns']} ns, "
+          f"overhead {info['overhead_ns']} ns, loop {info['loop_overhead_ns']:.1f} ns/iter, "
+          f"batch target {info['batch_target_ns'] / 1e3:.0f} µs")
+
+# ============ 잡음 통제 실행 ============
+#
+# set_controlled()로 켜면 측정마다 gc를 끄고, 측정 전에 워밍업을 하고, 측정 구간
+# 앞뒤의 getrusage 차이(컨텍스트 스위치, 페이지 폴트)를 기록한다. 비자발적
+# 컨텍스트 스위치나 메이저 폴트가 있었던 샘플은 OS에 방해받은 것으로 보고 다시 잰다.
+
+WARMUP_PASSES = 2
+MAX_RERUNS = 3
+RUSAGE_FIELDS = ("ru_nvcsw", "ru_nivcsw", "ru_minflt", "ru_majflt")
+RUSAGE_WHO = getattr(resource, "RUSAGE_THREAD", None) if resource else None
+
+_control = {"enabled": False, "cpu": None, "warmup": WARMUP_PASSES}
+
+# 리스트면 measure()가 잰 샘플마다 (코드, TimingResult)를 덧붙인다 (원시 샘플 저장용).
+# 병렬 스윕에서는 부모 프로세스의 SweepPool이 워커 결과로 채운다.
+sample_log = None
+
+def start_sample_log() -> list:
+    """원시 샘플 기록을 켜고 기록 리스트를 반환"""
+    global sample_log
+    sample_log = []
+    return sample_log
+
+def sample_rows(log: list, codes: list) -> list:
+    """sample_log 항목을 write_sample_file용 (코드 번호, n, raw_ns, loops, overhead_ns)로 바꾼다"""
+    return [(codes.index(code), result.n, result.raw_ns, result.loops, result.overhead_ns)
+            for code, result in log]
+
+# 이 프로세스에서 잰 샘플 수 / 방해받은 채로 남은 샘플 수 / 다시 잰 횟수
+disturbance_counts = {"samples": 0, "disturbed": 0, "reruns": 0}
+disturbed_points = []   # 방해받은 채로 남은 샘플의 n
+
+def pin_cpu(cpu: int):
+    """현재 프로세스를 cpu 하나에 고정"""
+    os.sched_setaffinity(0, {cpu})
+
+def set_controlled(enabled: bool = True, cpu: int = None, warmup: int = WARMUP_PASSES):
+    """잡음 통제 모드 설정. cpu를 주면 바로 그 CPU에 고정한다."""
+    _control.update(enabled=enabled, cpu=cpu, warmup=warmup)
+    if enabled and cpu is not None:
+        pin_cpu(cpu)
+
+def _rusage():
+    if RUSAGE_WHO is None:
+        return None
+    return resource.getrusage(RUSAGE_WHO)
+
+def _sample(compiled, namespace):
+    """(경과 ns, rusage 차이 또는 None). 통제 모드면 gc를 끄고 rusage를 앞뒤로 읽는다."""
+    if not _control["enabled"]:
+        return _run_timed(compiled, namespace), None
+    gc_was_enabled = gc.isenabled()
+    gc.disable()
+    try:
+        before = _rusage()
+        elapsed = _run_timed(compiled, namespace)
+        after = _rusage()
+    finally:
+        if gc_was_enabled:
+            gc.enable()
+    if before is None:
+        return elapsed, None
+    return elapsed, {field: getattr(after, field) - getattr(before, field) for field in RUSAGE_FIELDS}
+
+def is_disturbed(usage) -> bool:
+    """선점(비자발적 컨텍스트 스위치)이나 디스크에서 읽은 페이지 폴트가 있었는지"""
+    return bool(usage) and (usage["ru_nivcsw"] > 0 or usage["ru_majflt"] > 0)
+
+def _measure_once(compiled, batched, n, namespace, target) -> TimingResult:
+    raw, usage = _sample(compiled, namespace)
+    result = TimingResult(n, raw, timer_overhead_ns())
+    result.rusage = usage
+    if batched is None or raw >= target:
+        return result
+
+    # 첫 실행은 차가운 상태라 길게 나오므로, 묶음이 목표에 닿을 때까지 반복 수를 키운다
+    loops = 1
+    while raw < target and loops < MAX_LOOPS:
+        loops = min(MAX_LOOPS, max(loops * 2, math.ceil(loops * target * 1.2 / max(raw, 1))))
+        namespace["_timetest_loops"] = loops
+        raw, usage = _sample(batched, namespace)
+    result = TimingResult(n, raw, timer_overhead_ns() + loops * loop_overhead_ns(), loops)
+    result.rusage = usage
+    return result
+
+def measure(code: str, n: int, setup: str = DEFAULT_SETUP, batch: bool = True) -> TimingResult:
+    """code를 n에 대해 측정한다. 컴파일과 setup(기본: test_list 생성)은 측정 밖이다.
+
+    batch가 참이면 먼저 한 번 재 보고, 타이머 해상도의 BATCH_FACTOR배보다 짧으면
+    반복 수를 늘려 가며 묶음이 그 이상이 될 때까지 다시 재고 1회당 시간으로 나눈다.
+    반복은 같은 이름공간에서 일어나므로 test_list를 제자리에서 바꾸는 코드는 두 번째부터
+    바뀐 입력을 본다. 통제 모드에서는 워밍업 후 재고, 방해받은 샘플은 MAX_RERUNS번까지
+    다시 잰다 (결과의 disturbed, reruns, rusage 참고).
+    """
+    compiled = compile_snippet(code)
+    batched = compile_batched(code) if batch else None
+    target = batch_target_ns()
+    namespace = make_namespace(n, setup)
+
+    if _control["enabled"]:
+        gc.collect()
+        for _ in range(_control["warmup"]):
+            exec(compiled, namespace)
+
+    result = _measure_once(compiled, batched, n, namespace, target)
+    reruns = 0
+    while _control["enabled"] and is_disturbed(result.rusage) and reruns < MAX_RERUNS:
+        reruns += 1
+        result = _measure_once(compiled, batched, n, namespace, target)
+    result.reruns = reruns
+    result.disturbed = is_disturbed(result.rusage)
+    if sample_log is not None:
+        sample_log.append((code, result))
+
+    disturbance_counts["samples"] += 1
+    disturbance_counts["reruns"] += reruns
+    disturbance_counts["disturbed"] += result.disturbed
+    if result.disturbed:
+        disturbed_points.append(n)
+    return result
+
+def describe_disturbances():
+    counts = disturbance_counts
+    print(f"controlled run: {counts['samples']} samples, {counts['reruns']} re-runs, "
+          f"{counts['disturbed']} still disturbed after {MAX_RERUNS} re-runs")
+    if disturbed_points:
+        shown = ", ".join(str(n) for n in disturbed_points[:20])
+        print(f"disturbed n: {shown}{' ...' if len(disturbed_points) > 20 else ''}")
+
 def time_test(code: str, n: int)->float:
-    start = datetime.datetime.now()
-    n=n
-    test_list = [i for i in range(n)]
-    exec(code, globals(), locals())
-    end = datetime.datetime.now()
-    result = end-start
-    return result.total_seconds()
+    """오버헤드를 뺀 1회당 실행 시간(초). 짧은 코드는 자동으로 묶어 반복한다."""
+    return measure(code, n).seconds
+
+
+# ============ 코어 고정 병렬 스윕 ============
+
+NOISE_WINDOW = 2    # 잡음 기준선: 앞뒤 NOISE_WINDOW개 지점의 중앙값
+
+_worker_cpu = None
+
+def available_cpus() -> list:
+    """이 프로세스가 쓸 수 있는 CPU 번호 (정렬)"""
+    try:
+        return sorted(os.sched_getaffinity(0))
+    except AttributeError:
+        return list(range(os.cpu_count() or 1))
+
+def sweep_worker_count(workers: int = 0) -> int:
+    """실제로 띄울 워커 수. 0이면 CPU 수, CPU보다 많이 요청하면 CPU 수로 줄인다
+    (워커는 CPU 하나씩에 고정되므로 남는 워커는 같은 코어에 겹쳐 서로 방해한다)"""
+    cpus = len(available_cpus())
+    return min(workers, cpus) if workers > 0 else cpus
+
+def _sweep_worker_init(cpu_queue, codes: list, setup: str):
+    # 워커마다 CPU 하나에 고정하고, 코드별 컴파일/오버헤드 측정/웜업을 미리 끝낸다.
+    # 원시 샘플은 부모가 결과로 기록하므로 fork로 물려받은 기록은 끈다
+    global _worker_cpu, sample_log
+    sample_log = None
+    _worker_cpu = cpu_queue.get()
+    try:
+        os.sched_setaffinity(0, {_worker_cpu})
+    except (AttributeError, OSError):
+        pass
+    timer_info()
+    for code in codes:
+        compile_snippet(code)
+        for _ in range(3):
+            measure(code, 0, setup)
+
+def _sweep_worker_task(task):
+    code, index, n, setup = task
+    result = measure(code, n, setup)
+    return (index, result.seconds, os.getpid(), _worker_cpu, timer_overhead_ns(), result.disturbed,
+            (result.raw_ns, result.overhead_ns, result.loops))
+
+
+class WorkerStats:
+    """워커 하나의 잡음 통계. 각 지점의 이웃 중앙값 대비 상대 편차로 계산한다."""
+
+    def __init__(self, pid: int, cpu: int, overhead_ns: int, deviations: list, disturbed: int = 0):
+        self.pid = pid
+        self.cpu = cpu
+        self.overhead_ns = overhead_ns
+        self.disturbed = disturbed
+        self.points = len(deviations)
+        self.bias = statistics.fmean(deviations) if deviations else 0.0
+        self.noise = statistics.pstdev(deviations) if len(deviations) > 1 else 0.0
+
+    def __repr__(self):
+        return (f"WorkerStats(cpu={self.cpu}, points={self.points}, "
+                f"bias={self.bias:+.3f}, noise={self.noise:.3f})")
+
+
+def worker_noise_stats(times: list, owners: list, disturbed: list = None) -> list:
+    """owners[i] = (pid, cpu, overhead_ns), disturbed[i] = 방해받은 샘플 여부.
+    워커별 WorkerStats 목록 (CPU 순)"""
+    deviations = {}
+    disturbed_counts = {}
+    for i, t in enumerate(times):
+        lo, hi = max(i - NOISE_WINDOW, 0), min(i + NOISE_WINDOW + 1, len(times))
+        baseline = statistics.median(times[lo:hi])
+        deviations.setdefault(owners[i], []).append(t / baseline - 1.0 if baseline > 0 else 0.0)
+        disturbed_counts[owners[i]] = disturbed_counts.get(owners[i], 0) + bool(disturbed and disturbed[i])
+    stats = [WorkerStats(pid, cpu, overhead, devs, disturbed_counts[(pid, cpu, overhead)])
+             for (pid, cpu, overhead), devs in deviations.items()]
+    return sorted(stats, key=lambda stat: (stat.cpu, stat.pid))
+
+class SweepPool:
+    """CPU에 고정된 워커 프로세스 풀. 워커는 시작할 때 codes를 모두 컴파일/웜업하므로
+    여러 코드와 여러 번의 측정(예: 적응형 스윕의 세분 라운드)에 풀 하나를 재사용한다.
+    workers가 0이면 사용 가능한 CPU 수만큼이고, CPU 수보다 크면 CPU 수로 줄인다
+    (sweep_worker_count). with 블록이 끝나면 워커를 정리한다."""
+
+    def __init__(self, codes: list, workers: int = 0, setup: str = DEFAULT_SETUP):
+        cpus = available_cpus()
+        self.workers = sweep_worker_count(workers)
+        self.setup = setup
+        # fork로 띄워야 워커가 호출한 스크립트를 다시 import하지 않는다
+        context = multiprocessing.get_context("fork")
+        cpu_queue = context.Queue()
+        for i in range(self.workers):
+            cpu_queue.put(cpus[i])
+        self._pool = context.Pool(self.workers, _sweep_worker_init, (cpu_queue, list(codes), setup))
+
+    def imap_unordered(self, tasks):
+        """tasks는 (키, 코드, n) 목록. 끝나는 순서대로 (키, 초, (pid, cpu, 오버헤드 ns), 방해 여부)"""
+        work = [(code, (key, code, n), n, self.setup) for key, code, n in tasks]
+        # chunksize 1: 인접한 n이 서로 다른 워커에 돌아가 코어별 편차가 드러난다
+        for (key, code, n), seconds, pid, cpu, overhead, flagged, raw in self._pool.imap_unordered(
+                _sweep_worker_task, work, chunksize=1):
+            if sample_log is not None:
+                sample_log.append((code, TimingResult(n, *raw)))
+            yield key, seconds, (pid, cpu, overhead), flagged
 
+    def close(self, wait=True):
+        if wait:
+            self._pool.close()
+            self._pool.join()
+        else:
+            self._pool.terminate()
 
-def save_benchmark_to_csv(test_list, result, filename='benchmark_results.csv'):
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, traceback):
+        # 예외(중단 포함)로 빠져나가면 남은 작업을 기다리지 않는다
+        self.close(wait=exc_type is None)
+
+
+def parallel_sweep(code: str, n_range, workers: int = 0,
+                   setup: str = DEFAULT_SETUP, progress=None, pool: SweepPool = None):
+    """n 값들을 CPU에 고정된 워커 프로세스들에 나눠 측정한다.
+
+    n_range가 정수면 n = 0..n_range-1, 목록이면 그 n들(중복 허용)을 측정한다.
+    workers가 0이면 사용 가능한 CPU 수만큼. 반환값은 (n_range 순서의 초 단위 시간
+    목록, 워커별 WorkerStats 목록). progress(done, total)는 결과가 하나 올 때마다 호출된다.
+    pool을 주면 그 풀(code를 포함해 만든 것)을 쓰고, 없으면 이 호출 동안 풀을 띄운다.
+    """
+    if pool is None:
+        with SweepPool([code], workers, setup) as own_pool:
+            return parallel_sweep(code, n_range, workers, setup, progress, own_pool)
+
+    points = list(range(n_range)) if isinstance(n_range, int) else list(n_range)
+    times = [0.0] * len(points)
+    owners = [None] * len(points)
+    disturbed = [False] * len(points)
+    tasks = [(i, code, n) for i, n in enumerate(points)]
+    for done, (i, seconds, owner, flagged) in enumerate(pool.imap_unordered(tasks), start=1):
+        times[i] = seconds
+        owners[i] = owner
+        disturbed[i] = flagged
+        if progress:
+            progress(done, len(points))
+    return times, worker_noise_stats(times, owners, disturbed)
+
+def print_worker_stats(stats: list):
+    print("%-6s %-8s %7s %12s %9s %9s %10s" %
+          ("CPU", "PID", "Points", "Overhead", "Bias", "Noise", "Disturbed"))
+    for stat in stats:
+        print("%-6d %-8d %7d %9d ns %+8.1f%% %8.1f%% %10d" %
+              (stat.cpu, stat.pid, stat.points, stat.overhead_ns,
+               stat.bias * 100, stat.noise * 100, stat.disturbed))
+
+def save_benchmark_to_csv(test_list, result, filename='benchmark_results.csv', ns=None):
     """
     벤치마크 테스트 결과를 CSV 파일로 저장합니다.
 
@@ -49,6 +473,7 @@ def save_benchmark_to_csv(test_list, result, filename='benchmark_results.csv'):
         test_list: 테스트 요소들의 이름이 담긴 리스트
         result: 각 테스트의 실행 결과가 담긴 2차원 리스트
         filename: 저장할 CSV 파일명
+        ns: 각 행의 n 값 (없으면 실행 번호 1, 2, ...)
     """
 
     # 실행 횟수 (n) 계산
@@ -63,11 +488,109 @@ def save_benchmark_to_csv(test_list, result, filename='benchmark_results.csv'):
 
         # 각 실행 결과를 행으로 작성
         for i in range(n):
-            row = [i + 1]  # 실행 번호 (1부터 시작)
+            row = [ns[i] if ns else i + 1]  # n 또는 실행 번호 (1부터 시작)
             for j in range(len(test_list)):
                 row.append(result[j][i])
             writer.writerow(row)
 
+class ResultStream:
+    """n 하나가 끝날 때마다 한 행씩 CSV에 바로 쓰는 기록기 (save_benchmark_to_csv와 같은 형식)
+
+    행마다 flush해 OS 버퍼로 넘기고, sync_every행 또는 sync_seconds초마다 fsync한다.
+    중단되어도 그때까지의 행은 남는다. resume=True면 기존 파일의 헤더를 확인하고
+    잘린 마지막 행을 잘라낸 뒤 이어 쓴다. 이미 기록된 n은 done/recorded로 알 수 있다.
+    close()는 n 순서로 정렬한 파일을 임시 파일에 쓰고 os.replace로 바꿔 끼운다.
+    """
+
+    def __init__(self, filename, test_list, resume=False, sync_every=16, sync_seconds=5.0):
+        self.filename = filename
+        self.header = ['n'] + list(test_list)
+        self.sync_every = sync_every
+        self.sync_seconds = sync_seconds
+        self.recorded = {}      # n -> 값 목록 (resume으로 읽은 행과 새로 쓴 행)
+        self._pending = 0
+        self._last_sync = time.monotonic()
+
+        if resume and os.path.exists(filename):
+            self._load_existing()
+            self._file = open(filename, 'a', newline='', encoding='utf-8')
+        else:
+            self._file = open(filename, 'w', newline='', encoding='utf-8')
+            csv.writer(self._file).writerow(self.header)
+            self.sync()
+        self._writer = csv.writer(self._file)
+
+    @property
+    def done(self):
+        return self.recorded.keys()
+
+    def _load_existing(self):
+        # 마지막으로 온전히 기록된 행까지만 남기고 잘라낸다 (쓰는 도중 죽은 경우)
+        good_end = 0
+        with open(self.filename, 'rb') as f:
+            data = f.read()
+        lines = data.split(b'\n')
+        for index, raw in enumerate(lines[:-1]):   # 마지막 조각은 줄바꿈이 없으면 미완성
+            row = next(csv.reader([raw.decode('utf-8').rstrip('\r')]), [])
+            if index == 0:
+                if row != self.header:
+                    raise ValueError(f"{self.filename}: header {row} does not match {self.header}")
+            else:
+                try:
+                    values = [float(value) for value in row[1:]]
+                    n = int(float(row[0]))
+                except (ValueError, IndexError):
+                    break
+                if len(values) != len(self.header) - 1:
+                    break
+                self.recorded[n] = values
+            good_end += len(raw) + 1
+        if good_end == 0:
+            raise ValueError(f"{self.filename}: no header to resume from")
+        if good_end < len(data):
+            with open(self.filename, 'r+b') as f:
+                f.truncate(good_end)
+
+    def write(self, n, values):
+        """n 하나의 결과(코드 순서의 값 목록)를 기록"""
+        self._writer.writerow([n] + list(values))
+        self.recorded[n] = list(values)
+        self._file.flush()
+        self._pending += 1
+        if self._pending >= self.sync_every or time.monotonic() - self._last_sync >= self.sync_seconds:
+            self.sync()
+
+    def sync(self):
+        self._file.flush()
+        os.fsync(self._file.fileno())
+        self._pending = 0
+        self._last_sync = time.monotonic()
+
+    def close(self, sort=True):
+        if self._file.closed:
+            return
+        self.sync()
+        self._file.close()
+        if sort:
+            temp = self.filename + '.tmp'
+            with open(temp, 'w', newline='', encoding='utf-8') as f:
+                writer = csv.writer(f)
+                writer.writerow(self.header)
+                for n in sorted(self.recorded):
+                    writer.writerow([n] + self.recorded[n])
+                f.flush()
+                os.fsync(f.fileno())
+            os.replace(temp, self.filename)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc, tb):
+        # 예외(Ctrl-C 포함)로 끝나도 기록된 행은 fsync하고 정렬해 둔다
+        self.close()
+        return False
+
 def multi(n: int, code: str = "random.random()"):
+    compiled = compile_snippet(code)
     for i in range(n):
-        exec(code)
\ No newline at end of file
+        exec(compiled)
\ No newline at end of file